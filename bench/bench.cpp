@@ -0,0 +1,708 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <libcli.hpp>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::string_literals;
+
+namespace {
+
+std::atomic<std::size_t> allocation_count{0};
+
+}  // namespace
+
+#if defined(__GNUC__) && !defined(__clang__)
+// The replacements below pair malloc with free, which GCC cannot tell.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// Every global allocation is counted so that scenarios can report how many
+// heap allocations a single parse performs. The aligned forms matter too:
+// std::pmr::new_delete_resource allocates through them.
+auto operator new(std::size_t size) -> void*
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc, hicpp-no-malloc)
+    if (auto* const ptr = std::malloc(size == 0 ? 1 : size)) { return ptr; }
+    throw std::bad_alloc{};
+}
+
+auto operator new(std::size_t size, std::align_val_t alignment) -> void*
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    auto const align = static_cast<std::size_t>(alignment);
+    auto const rounded = (std::max(size, std::size_t{1}) + align - 1)
+                         / align * align;
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc, hicpp-no-malloc)
+    if (auto* const ptr = std::aligned_alloc(align, rounded)) { return ptr; }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc, hicpp-no-malloc)
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*unused*/) noexcept
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc, hicpp-no-malloc)
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t /*unused*/) noexcept
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc, hicpp-no-malloc)
+    std::free(ptr);
+}
+
+void operator delete(
+    void* ptr,
+    std::size_t /*unused*/,
+    std::align_val_t /*unused*/) noexcept
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc, hicpp-no-malloc)
+    std::free(ptr);
+}
+
+namespace {
+
+// Owns the strings of a synthetic command line and the argv pointing at
+// them.
+class command_line {
+    std::vector<std::string> strs;
+    std::vector<char const*> ptrs;
+
+   public:
+    explicit command_line(std::vector<std::string> args)
+        : strs{std::move(args)}
+    {
+        strs.insert(strs.begin(), "bench");
+        ptrs.reserve(strs.size());
+        for (auto const& s : strs) { ptrs.push_back(s.c_str()); }
+    }
+
+    auto argc() const -> int { return static_cast<int>(ptrs.size()); }
+
+    auto argv() const -> char const* const* { return ptrs.data(); }
+
+    auto num_args() const -> std::size_t { return strs.size() - 1; }
+};
+
+struct result {
+    std::string name;
+    std::size_t num_args;
+    std::size_t iterations;
+    double ns_per_parse;
+    double args_per_second;
+    double allocations_per_parse;
+};
+
+struct settings {
+    double min_seconds = 0.2;
+    std::string filter;
+    bool json = false;
+};
+
+// Runs body until at least min_seconds have passed, after one warm-up call.
+auto measure(
+    settings const& s,
+    std::string name,
+    std::size_t num_args,
+    std::function<void()> const& body) -> result
+{
+    using clock = std::chrono::steady_clock;
+    body();
+    auto iterations = std::size_t{0};
+    auto const allocations_before = allocation_count.load();
+    auto const start = clock::now();
+    auto elapsed = std::chrono::duration<double>{};
+    do {
+        body();
+        ++iterations;
+        elapsed = clock::now() - start;
+    } while (elapsed.count() < s.min_seconds);
+    auto const allocations = allocation_count.load() - allocations_before;
+    auto const seconds = elapsed.count();
+    auto const n = static_cast<double>(iterations);
+    return {
+        std::move(name),
+        num_args,
+        iterations,
+        seconds * 1e9 / n,
+        static_cast<double>(num_args) * n / seconds,
+        static_cast<double>(allocations) / n};
+}
+
+auto option_name(std::size_t i) -> std::string
+{
+    return "--option-" + std::to_string(i);
+}
+
+auto letter(std::size_t i) -> char
+{
+    constexpr auto letters = std::string_view{
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"};
+    return letters[i % letters.size()];
+}
+
+// There are only 52 single-letter shorthands; later options have none.
+constexpr auto max_options = std::size_t{52};
+
+auto shorthand(std::size_t i) -> std::string
+{
+    return i < max_options ? "-"s + letter(i) : ""s;
+}
+
+void option_count(settings const& s, std::vector<result>& out)
+{
+    for (auto const num_options :
+         {std::size_t{10}, max_options, std::size_t{1000}}) {
+        auto values = std::vector<int>(num_options);
+        auto cli = libcli::cli{};
+        auto args = std::vector<std::string>{};
+        for (auto i = std::size_t{0}; i < num_options; ++i) {
+            cli.add_option(values[i], option_name(i), shorthand(i));
+            args.push_back(option_name(i));
+            args.push_back(std::to_string(i));
+        }
+        auto const cmd = command_line{std::move(args)};
+        out.push_back(measure(
+            s,
+            "options/" + std::to_string(num_options),
+            cmd.num_args(),
+            [&] { cli.parse(cmd.argc(), cmd.argv()); }));
+    }
+}
+
+void observed(settings const& s, std::vector<result>& out)
+{
+    auto values = std::vector<int>(max_options);
+    auto cli = libcli::cli{};
+    auto args = std::vector<std::string>{};
+    for (auto i = std::size_t{0}; i < max_options; ++i) {
+        cli.add_option(values[i], option_name(i), shorthand(i));
+        args.push_back(option_name(i));
+        args.push_back(std::to_string(i));
+    }
+    auto const cmd = command_line{std::move(args)};
+    auto stats = libcli::parse_statistics{};
+    out.push_back(measure(
+        s,
+        "observed/statistics/" + std::to_string(max_options),
+        cmd.num_args(),
+        [&] { cli.parse(cmd.argc(), cmd.argv(), stats); }));
+}
+
+// Converted through operator>>, like most user-defined types.
+struct streamed_value {
+    double value = 0;
+
+    friend auto operator>>(std::istream& is, streamed_value& x)
+        -> std::istream&
+    {
+        return is >> x.value;
+    }
+};
+
+template <typename T>
+void lazy_options(
+    settings const& s,
+    std::string const& name,
+    std::vector<result>& out)
+{
+    auto values = std::vector<T>(max_options);
+    auto cli = libcli::cli{};
+    auto args = std::vector<std::string>{};
+    for (auto i = std::size_t{0}; i < max_options; ++i) {
+        cli.add_option(values[i], option_name(i), shorthand(i));
+        args.push_back(option_name(i));
+        args.push_back(std::to_string(i) + ".5");
+    }
+    auto const cmd = command_line{std::move(args)};
+    out.push_back(measure(s, name, cmd.num_args(), [&] {
+        cli.parse(cmd.argc(), cmd.argv());
+        // Most code paths only read a few of the options.
+        if constexpr (!std::same_as<T, streamed_value>) {
+            static_cast<void>(values[0].get());
+            static_cast<void>(values[1].get());
+        }
+    }));
+}
+
+void lazy_conversion(settings const& s, std::vector<result>& out)
+{
+    lazy_options<streamed_value>(s, "lazy/eager/52", out);
+    lazy_options<libcli::lazy<streamed_value>>(s, "lazy/read_2_of_52", out);
+}
+
+void registration(settings const& s, std::vector<result>& out)
+{
+    for (auto const num_options : {std::size_t{100}, std::size_t{2000}}) {
+        auto values = std::vector<int>(num_options);
+        auto names = std::vector<std::string>{};
+        auto shorthands = std::vector<std::string>{};
+        auto definitions = std::vector<libcli::option_definition>{};
+        for (auto i = std::size_t{0}; i < num_options; ++i) {
+            names.push_back(option_name(i));
+            shorthands.push_back(shorthand(i));
+        }
+        for (auto i = std::size_t{0}; i < num_options; ++i) {
+            definitions.emplace_back(values[i], names[i], shorthands[i]);
+        }
+        out.push_back(measure(
+            s,
+            "registration/" + std::to_string(num_options),
+            0,
+            [&] {
+                auto cli = libcli::cli{};
+                for (auto i = std::size_t{0}; i < num_options; ++i) {
+                    cli.add_option(values[i], names[i], shorthands[i]);
+                }
+            }));
+        out.push_back(measure(
+            s,
+            "registration/bulk/" + std::to_string(num_options),
+            0,
+            [&] {
+                auto cli = libcli::cli{};
+                cli.add_options(definitions);
+            }));
+    }
+}
+
+// Binds a vector that starts out empty on every parse, so that it has to
+// grow to the number of values.
+template <typename T>
+void argv_growth(
+    settings const& s,
+    std::string const& name,
+    std::vector<result>& out)
+{
+    constexpr auto n = std::size_t{100'000};
+    auto args = std::vector<std::string>{};
+    for (auto i = std::size_t{0}; i < n; ++i) {
+        args.push_back("src/file_" + std::to_string(i) + ".cpp");
+    }
+    auto const cmd = command_line{std::move(args)};
+    out.push_back(measure(s, name + "/" + std::to_string(n), n, [&] {
+        auto values = std::vector<T>{};
+        auto cli = libcli::cli{};
+        cli.add_argument(libcli::multi, values);
+        cli.parse(cmd.argc(), cmd.argv());
+    }));
+}
+
+void argv_length(settings const& s, std::vector<result>& out)
+{
+    for (auto n = std::size_t{10}; n <= 1'000'000; n *= 10) {
+        auto values = std::vector<std::string>{};
+        values.reserve(n);
+        auto cli = libcli::cli{};
+        cli.add_argument(libcli::multi, values);
+        auto args = std::vector<std::string>{};
+        for (auto i = std::size_t{0}; i < n; ++i) {
+            args.push_back("src/file_" + std::to_string(i) + ".cpp");
+        }
+        auto const cmd = command_line{std::move(args)};
+        out.push_back(measure(
+            s,
+            "argv/" + std::to_string(n),
+            cmd.num_args(),
+            [&] {
+                values.clear();
+                cli.parse(cmd.argc(), cmd.argv());
+            }));
+    }
+    argv_growth<std::string>(s, "argv/fresh_vector", out);
+    argv_growth<std::string_view>(s, "argv/string_views", out);
+}
+
+void clustered_flags(settings const& s, std::vector<result>& out)
+{
+    auto flags = std::array<bool, max_options>{};
+    auto cli = libcli::cli{};
+    auto cluster = "-"s;
+    for (auto i = std::size_t{0}; i < max_options; ++i) {
+        cli.add_option(flags[i], option_name(i), "-"s + letter(i));
+        cluster += letter(i);
+    }
+    auto const cmd = command_line{std::vector<std::string>(100, cluster)};
+    out.push_back(measure(
+        s,
+        "clustered_flags/100x" + std::to_string(max_options),
+        cmd.num_args(),
+        [&] { cli.parse(cmd.argc(), cmd.argv()); }));
+
+    auto word = std::uint64_t{0};
+    auto bits_cli = libcli::cli{};
+    for (auto i = std::size_t{0}; i < max_options; ++i) {
+        bits_cli.add_option(
+            libcli::bit(word, i),
+            option_name(i),
+            "-"s + letter(i));
+    }
+    out.push_back(measure(
+        s,
+        "clustered_flags/bits/100x" + std::to_string(max_options),
+        cmd.num_args(),
+        [&] { bits_cli.parse(cmd.argc(), cmd.argv()); }));
+}
+
+void equal_sign_options(settings const& s, std::vector<result>& out)
+{
+    auto values = std::vector<std::string>(max_options);
+    auto cli = libcli::cli{};
+    auto args = std::vector<std::string>{};
+    for (auto i = std::size_t{0}; i < max_options; ++i) {
+        cli.add_option(values[i], option_name(i), "-"s + letter(i));
+        args.push_back(option_name(i) + "=value_" + std::to_string(i));
+    }
+    auto const cmd = command_line{std::move(args)};
+    out.push_back(measure(
+        s,
+        "equal_sign/" + std::to_string(max_options),
+        cmd.num_args(),
+        [&] { cli.parse(cmd.argc(), cmd.argv()); }));
+}
+
+// Help for every option, first rendered and then served from the cache.
+void help_text(settings const& s, std::vector<result>& out)
+{
+    auto values = std::vector<int>(max_options);
+    auto cli = libcli::cli{};
+    for (auto i = std::size_t{0}; i < max_options; ++i) {
+        cli.add_option(values[i], option_name(i), "-"s + letter(i))
+            .describe("Sets option number " + std::to_string(i)
+                      + " of the benchmark, which does nothing at all");
+    }
+    auto width = std::size_t{80};
+    out.push_back(measure(
+        s,
+        "help/render/" + std::to_string(max_options),
+        0,
+        [&] {
+            // A new width makes the help render again.
+            width = width == 80 ? 81 : 80;
+            (void)cli.help("bench", width);
+        }));
+    out.push_back(measure(
+        s,
+        "help/cached/" + std::to_string(max_options),
+        0,
+        [&] { (void)cli.help("bench", 80); }));
+}
+
+// Command lines that fail on their last value, reported by exception and by
+// try_parse.
+void malformed(settings const& s, std::vector<result>& out)
+{
+    constexpr auto num_options = std::size_t{10};
+    auto values = std::vector<int>(num_options);
+    auto cli = libcli::cli{};
+    auto args = std::vector<std::string>{};
+    for (auto i = std::size_t{0}; i < num_options; ++i) {
+        cli.add_option(values[i], option_name(i), "-"s + letter(i));
+        args.push_back(option_name(i));
+        args.push_back(i + 1 == num_options ? "abc" : std::to_string(i));
+    }
+    auto const cmd = command_line{std::move(args)};
+    auto const views = std::vector<std::string_view>(
+        cmd.argv(),
+        cmd.argv() + cmd.argc());
+    out.push_back(measure(
+        s,
+        "malformed/throwing",
+        cmd.num_args(),
+        [&] {
+            try {
+                cli.parse(views);
+            }
+            catch (libcli::parsing_error const&) {
+            }
+        }));
+    out.push_back(measure(
+        s,
+        "malformed/try_parse",
+        cmd.num_args(),
+        [&] {
+            if (cli.try_parse(views)) { std::abort(); }
+        }));
+}
+
+// Loads a config file of 10k keys spread over the options; num_args counts
+// the keys.
+void config_file(settings const& s, std::vector<result>& out)
+{
+    constexpr auto n = std::size_t{10'000};
+    auto values = std::vector<int>(max_options);
+    auto cli = libcli::cli{};
+    for (auto i = std::size_t{0}; i < max_options; ++i) {
+        cli.add_option(values[i], option_name(i), "-"s + letter(i));
+    }
+    auto const path =
+        (std::filesystem::temp_directory_path() / "libcli_bench.conf")
+            .string();
+    {
+        auto file = std::ofstream{path};
+        for (auto i = std::size_t{0}; i < n; ++i) {
+            file << option_name(i % max_options).substr(2) << " = " << i
+                 << '\n';
+        }
+    }
+    out.push_back(measure(
+        s,
+        "config/" + std::to_string(n),
+        n,
+        [&] { cli.load_config(path); }));
+    std::filesystem::remove(path);
+}
+
+void response_file(settings const& s, std::vector<result>& out)
+{
+    constexpr auto n = std::size_t{100'000};
+    auto values = std::vector<std::string>{};
+    values.reserve(n);
+    auto cli = libcli::cli{};
+    cli.add_argument(libcli::multi, values);
+    cli.enable_response_files();
+    auto const path =
+        (std::filesystem::temp_directory_path() / "libcli_bench.rsp").string();
+    {
+        auto file = std::ofstream{path};
+        for (auto i = std::size_t{0}; i < n; ++i) {
+            file << "/usr/share/libcli/bench/data/file-" << i << ".txt\n";
+        }
+    }
+    auto const arg = "@" + path;
+    out.push_back(measure(s, "response_file/" + std::to_string(n), n, [&] {
+        values.clear();
+        cli.parse({"bench", arg.c_str()});
+    }));
+    std::filesystem::remove(path);
+}
+
+template <typename T>
+void conversion(
+    settings const& s,
+    std::string const& type_name,
+    std::vector<result>& out)
+{
+    constexpr auto n = std::size_t{100'000};
+    auto values = std::vector<T>{};
+    values.reserve(n);
+    auto cli = libcli::cli{};
+    cli.add_argument(libcli::multi, values);
+    auto args = std::vector<std::string>{};
+    for (auto i = std::size_t{0}; i < n; ++i) {
+        args.push_back(std::to_string(i * 7919));
+    }
+    auto const cmd = command_line{std::move(args)};
+    out.push_back(measure(
+        s,
+        "conversion/" + type_name + "/" + std::to_string(n),
+        cmd.num_args(),
+        [&] {
+            values.clear();
+            cli.parse(cmd.argc(), cmd.argv());
+        }));
+}
+
+void large_multi_argument(settings const& s, std::vector<result>& out)
+{
+    constexpr auto n = std::size_t{1'000'000};
+    auto first = ""s;
+    auto values = std::vector<long>{};
+    auto last = ""s;
+    auto cli = libcli::cli{};
+    cli.add_argument(first);
+    cli.add_argument(libcli::multi, values);
+    cli.add_argument(last);
+    auto args = std::vector<std::string>{};
+    for (auto i = std::size_t{0}; i < n; ++i) {
+        args.push_back(std::to_string(i));
+    }
+    auto const cmd = command_line{std::move(args)};
+    out.push_back(measure(
+        s,
+        "multi_argument/vector/" + std::to_string(n),
+        cmd.num_args(),
+        [&] {
+            values.clear();
+            cli.parse(cmd.argc(), cmd.argv());
+        }));
+
+    auto parallel = libcli::cli{};
+    parallel.add_argument(first);
+    parallel.add_argument(libcli::parallel_multi, values);
+    parallel.add_argument(last);
+    out.push_back(measure(
+        s,
+        "multi_argument/parallel/" + std::to_string(n),
+        cmd.num_args(),
+        [&] {
+            values.clear();
+            parallel.parse(cmd.argc(), cmd.argv());
+        }));
+
+    auto sum = long{0};
+    auto sink = [&](long x) { sum += x; };
+    auto streaming = libcli::cli{};
+    streaming.add_argument(first);
+    streaming.add_argument<long>(libcli::multi, sink);
+    streaming.add_argument(last);
+    out.push_back(measure(
+        s,
+        "multi_argument/sink/" + std::to_string(n),
+        cmd.num_args(),
+        [&] { streaming.parse(cmd.argc(), cmd.argv()); }));
+}
+
+struct job {
+    bool verbose = false;
+    std::optional<int> priority;
+    std::string name;
+    std::string command;
+    std::vector<std::string> files;
+};
+
+// The same batch parsed with 1, 2, 4, ... threads up to the hardware
+// concurrency, to show how parse_batch scales.
+void batch(settings const& s, std::vector<result>& out)
+{
+    constexpr auto num_lines = std::size_t{100'000};
+    auto p = libcli::parser<job>{};
+    p.add_option<&job::verbose>("--verbose", "-v");
+    p.add_option<&job::priority>("--priority", "-p");
+    p.add_option<&job::name>("--name", "-n");
+    p.add_argument<&job::command>();
+    p.add_argument<&job::files>(libcli::multi);
+
+    auto storage = std::vector<std::string>{};
+    storage.reserve(num_lines);
+    for (auto i = std::size_t{0}; i < num_lines; ++i) {
+        storage.push_back("--name=job_" + std::to_string(i));
+    }
+    auto lines = std::vector<std::vector<std::string_view>>{};
+    lines.reserve(num_lines);
+    for (auto const& name : storage) {
+        lines.push_back(
+            {"bench", "-v", "-p", "10", name, "run", "a.txt", "b.txt"});
+    }
+    auto const num_args = num_lines * (lines.front().size() - 1);
+
+    auto const max_threads = std::max(
+        std::size_t{1},
+        std::size_t{std::thread::hardware_concurrency()});
+    for (auto threads = std::size_t{1}; threads <= max_threads; threads *= 2) {
+        out.push_back(measure(
+            s,
+            "batch/" + std::to_string(num_lines) + "/threads/"
+                + std::to_string(threads),
+            num_args,
+            [&] { (void)p.parse_batch(lines, threads); }));
+    }
+}
+
+void print_table(std::vector<result> const& results)
+{
+    std::printf(
+        "%-36s %10s %14s %14s %12s\n",
+        "scenario",
+        "args",
+        "ns/parse",
+        "args/s",
+        "allocs/parse");
+    for (auto const& r : results) {
+        std::printf(
+            "%-36s %10zu %14.0f %14.3g %12.1f\n",
+            r.name.c_str(),
+            r.num_args,
+            r.ns_per_parse,
+            r.args_per_second,
+            r.allocations_per_parse);
+    }
+}
+
+// One JSON object per line, so results can be appended to a log and
+// compared between revisions.
+void print_json(std::vector<result> const& results)
+{
+    for (auto const& r : results) {
+        std::printf(
+            "{\"name\":\"%s\",\"args\":%zu,\"iterations\":%zu,"
+            "\"ns_per_parse\":%.1f,\"args_per_second\":%.1f,"
+            "\"allocations_per_parse\":%.2f}\n",
+            r.name.c_str(),
+            r.num_args,
+            r.iterations,
+            r.ns_per_parse,
+            r.args_per_second,
+            r.allocations_per_parse);
+    }
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto s = settings{};
+    auto cli = libcli::cli{};
+    cli.add_option(s.json, "--json", "-j");
+    cli.add_option(s.filter, "--filter", "-f");
+    cli.add_option(s.min_seconds, "--min-time", "-t");
+    try {
+        cli.parse(argc, argv);
+    }
+    catch (libcli::parsing_error const& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+
+    using scenario = void (*)(settings const&, std::vector<result>&);
+    auto const scenarios = std::vector<std::pair<std::string, scenario>>{
+        {"options", option_count},
+        {"observed", observed},
+        {"registration", registration},
+        {"lazy", lazy_conversion},
+        {"argv", argv_length},
+        {"clustered_flags", clustered_flags},
+        {"equal_sign", equal_sign_options},
+        {"config", config_file},
+        {"response_file", response_file},
+        {"malformed", malformed},
+        {"help", help_text},
+        {"conversion",
+         [](settings const& s, std::vector<result>& out) {
+             conversion<int>(s, "int", out);
+             conversion<double>(s, "double", out);
+             conversion<std::string>(s, "string", out);
+         }},
+        {"multi_argument", large_multi_argument},
+        {"batch", batch},
+    };
+
+    auto results = std::vector<result>{};
+    for (auto const& [name, run] : scenarios) {
+        if (name.find(s.filter) != std::string::npos) { run(s, results); }
+    }
+    if (s.json) { print_json(results); }
+    else {
+        print_table(results);
+    }
+}
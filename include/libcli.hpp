@@ -2,24 +2,78 @@
 #define LIBCLI_CLI_HPP
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <bitset>
 #include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
 #include <concepts>
-#include <memory>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <ranges>
+#include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LIBCLI_HAS_MMAP 1
+#else
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#define LIBCLI_HAS_MMAP 0
+#endif
+
+#if defined(_WIN32)
+#include <stdlib.h>
+#elif defined(__APPLE__)
+#include <crt_externs.h>
+#else
+#include <unistd.h>
+#endif
+
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define LIBCLI_HAS_USDT 1
+#else
+#define LIBCLI_HAS_USDT 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIBCLI_HAS_SSE2 1
+#else
+#define LIBCLI_HAS_SSE2 0
+#endif
+
 namespace libcli {
 
 namespace detail {
 
-using namespace std::string_literals;
-
 template <typename... Ts>
 struct overloaded : Ts... {
     using Ts::operator()...;
@@ -37,6 +91,16 @@ inline auto join(Ts&&... ts) -> std::string
     return ss.str();
 }
 
+// Makes room for count more elements at once, growing at least twofold so
+// that repeated calls stay amortized.
+template <typename Vector>
+inline void reserve_more(Vector& vec, std::size_t count)
+{
+    if (vec.capacity() - vec.size() < count) {
+        vec.reserve(std::max(vec.size() + count, 2 * vec.capacity()));
+    }
+}
+
 }  // namespace detail
 
 struct invalid_cli_definition : public std::invalid_argument {
@@ -47,6 +111,140 @@ struct parsing_error : public std::runtime_error {
     using runtime_error::runtime_error;
 };
 
+// Kinds of parse failures reported by try_parse.
+enum class parse_errc {
+    not_an_option,
+    not_a_flag,
+    flag_with_value,
+    missing_value,
+    invalid_value,
+    out_of_range,
+    wrong_number_of_arguments,
+    not_a_command,
+    missing_command,
+    unreadable_response_file,
+    unterminated_quote,
+    recursive_response_file,
+};
+
+// A parse failure as a plain value, so reporting it neither throws nor
+// allocates; the message is only built by message(). text views the part
+// of the input at fault and stays valid as long as the input does: an
+// argument or a value, a single letter of a cluster such as -abc, or a
+// whole NAME=value entry for environment variables. For anything read from
+// a response file, text views the file, which the cli keeps mapped until
+// its next parse or its destruction, and argv_index is the @ argument's.
+struct parse_error {
+    static constexpr auto npos = std::numeric_limits<std::size_t>::max();
+
+    parse_errc kind;
+    std::string_view text;
+    // Index in argv of the argument at fault, or npos.
+    std::size_t argv_index = npos;
+    // Index of the option at fault in order of definition, or npos.
+    std::size_t option_index = npos;
+    // Whether text is a letter of a cluster, which message() shows as the
+    // option "-x" it stands for.
+    bool is_cluster_letter = false;
+
+    auto message() const -> std::string
+    {
+        auto const name =
+            is_cluster_letter ? detail::join('-', text) : std::string{text};
+        switch (kind) {
+            case parse_errc::not_an_option:
+                return detail::join(name, " is not an option");
+            case parse_errc::not_a_flag:
+                return detail::join(name, " is not a flag");
+            case parse_errc::flag_with_value:
+                return detail::join(text, " is invalid");
+            case parse_errc::missing_value:
+                return detail::join(text, " is missing an argument");
+            case parse_errc::invalid_value:
+                return detail::join(text, " is not a valid value");
+            case parse_errc::out_of_range:
+                return detail::join(text, " is out of range");
+            case parse_errc::wrong_number_of_arguments:
+                return "Wrong number of arguments";
+            case parse_errc::not_a_command:
+                return detail::join(text, " is not a command");
+            case parse_errc::missing_command:
+                return "Missing command";
+            case parse_errc::unreadable_response_file:
+                return detail::join(text, " cannot be read");
+            case parse_errc::unterminated_quote:
+                return detail::join(text, " has an unterminated quote");
+            case parse_errc::recursive_response_file:
+                return detail::join(text, " includes itself");
+        }
+        return {};
+    }
+};
+
+// What try_parse returns: a T or the parse_error that prevented it, shaped
+// like std::expected<T, parse_error>.
+template <typename T>
+class parse_result {
+    std::variant<T, parse_error> outcome;
+
+   public:
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    parse_result(T value) : outcome{std::in_place_index<0>, std::move(value)}
+    {
+    }
+
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    parse_result(parse_error error) : outcome{std::in_place_index<1>, error}
+    {
+    }
+
+    auto has_value() const -> bool { return outcome.index() == 0; }
+
+    explicit operator bool() const { return has_value(); }
+
+    auto operator*() & -> T& { return std::get<0>(outcome); }
+
+    auto operator*() const& -> T const& { return std::get<0>(outcome); }
+
+    auto operator*() && -> T&& { return std::get<0>(std::move(outcome)); }
+
+    auto operator->() -> T* { return &std::get<0>(outcome); }
+
+    auto operator->() const -> T const* { return &std::get<0>(outcome); }
+
+    // Throws parsing_error when there is no value.
+    auto value() && -> T
+    {
+        if (!has_value()) { throw parsing_error{error().message()}; }
+        return std::get<0>(std::move(outcome));
+    }
+
+    auto error() const -> parse_error const& { return std::get<1>(outcome); }
+};
+
+template <>
+class parse_result<void> {
+    std::optional<parse_error> failure;
+
+   public:
+    parse_result() = default;
+
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    parse_result(parse_error error) : failure{error} {}
+
+    auto has_value() const -> bool { return !failure; }
+
+    explicit operator bool() const { return has_value(); }
+
+    // Throws parsing_error when parsing failed.
+    void value() const
+    {
+        if (failure) { throw parsing_error{failure->message()}; }
+    }
+
+    auto error() const -> parse_error const& { return *failure; }
+};
+
 // clang-format off
 template <typename T>
 concept istreamable = requires(std::istream& is, T& x) {
@@ -54,22 +252,192 @@ concept istreamable = requires(std::istream& is, T& x) {
 };;
 // clang-format on
 
+// What options and arguments can be bound to. A std::string_view views the
+// text of the argument itself, without copying it. A view into argv lives
+// as long as argv; a view into a response file, or into any file read by
+// a subcommand, until the cli's next parse or its destruction; a view into
+// a config file loaded on the cli itself, as long as the cli.
+template <typename T>
+concept bindable = istreamable<T> || std::same_as<T, std::string_view>;
+
 namespace detail {
 
-inline void from_string(std::string_view input, std::string& out)
+// Conversions return the kind of error instead of throwing, so that a bad
+// value costs no more than a good one.
+inline auto from_string(std::string_view input, std::string& out)
+    -> std::optional<parse_errc>
+{
+    out = input;
+    return std::nullopt;
+}
+
+inline auto from_string(std::string_view input, std::string_view& out)
+    -> std::optional<parse_errc>
 {
     out = input;
+    return std::nullopt;
 }
 
 template <istreamable T>
-inline void from_string(std::string_view input, T& out)
+inline auto from_string(std::string_view input, T& out)
+    -> std::optional<parse_errc>
 {
     auto ss = std::stringstream{};
     ss << input;
     ss >> out;
-    if (ss.fail()) {
-        throw parsing_error(join(input, " is not a valid value"));
+    if (ss.fail()) { return parse_errc::invalid_value; }
+    return std::nullopt;
+}
+
+template <typename T>
+concept character =
+    std::same_as<T, char> || std::same_as<T, signed char>
+    || std::same_as<T, unsigned char> || std::same_as<T, wchar_t>
+    || std::same_as<T, char8_t> || std::same_as<T, char16_t>
+    || std::same_as<T, char32_t>;
+
+// Types std::from_chars can convert; characters and bool keep going through
+// the stream so that their textual form doesn't change.
+template <typename T>
+concept charconv_parsable =
+    istreamable<T>
+    && ((std::integral<T> && !std::same_as<T, bool> && !character<T>)
+        || std::floating_point<T>);
+
+template <charconv_parsable T>
+inline auto from_string(std::string_view input, T& out)
+    -> std::optional<parse_errc>
+{
+    auto digits = input;
+    if (digits.starts_with('+') && !digits.substr(1).starts_with('-')) {
+        digits.remove_prefix(1);
+    }
+    auto const* const last = digits.data() + digits.size();
+    auto const [ptr, ec] = std::from_chars(digits.data(), last, out);
+    if (ec == std::errc::result_out_of_range) {
+        return parse_errc::out_of_range;
+    }
+    if (ec != std::errc{} || ptr != last) { return parse_errc::invalid_value; }
+    return std::nullopt;
+}
+
+}  // namespace detail
+
+// A value whose text is only converted to T when it is first read, for
+// options that are costly to convert and not always needed. The text is
+// copied, so it does not have to outlive the parse. A bad value is
+// reported when it is read, or by cli::validate_all. Reading it from
+// several threads before the first read has finished is a data race.
+template <istreamable T>
+    requires std::default_initializable<T>
+class lazy {
+    std::string text;
+    mutable std::optional<T> value;
+    bool is_given = false;
+
+   public:
+    lazy() = default;
+
+    // default_value is what reading yields when no text was given.
+    explicit lazy(T default_value) : value{std::move(default_value)} {}
+
+    // Whether an option or argument gave the text.
+    auto has_text() const -> bool { return is_given; }
+
+    auto raw() const -> std::string_view { return text; }
+
+    void assign(std::string_view input)
+    {
+        text = input;
+        is_given = true;
+        value.reset();
+    }
+
+    // Converts the text, unless that has already been done, and returns
+    // what went wrong instead of throwing.
+    auto validate() const -> std::optional<parse_error>
+    {
+        if (!is_given || value) { return std::nullopt; }
+        auto converted = T{};
+        if (auto const kind = detail::from_string(text, converted)) {
+            return parse_error{*kind, text};
+        }
+        value = std::move(converted);
+        return std::nullopt;
+    }
+
+    // Throws parsing_error when the text is not a valid T.
+    auto get() const -> T const&
+    {
+        if (auto const error = validate()) {
+            throw parsing_error{error->message()};
+        }
+        if (!value) { value.emplace(); }
+        return *value;
+    }
+
+    auto operator*() const -> T const& { return get(); }
+
+    auto operator->() const -> T const* { return &get(); }
+
+    friend auto operator>>(std::istream& is, lazy& var) -> std::istream&
+    {
+        var.assign(std::string{std::istreambuf_iterator<char>{is}, {}});
+        return is;
     }
+};
+
+namespace detail {
+
+template <typename T>
+inline auto from_string(std::string_view input, lazy<T>& out)
+    -> std::optional<parse_errc>
+{
+    out.assign(input);
+    return std::nullopt;
+}
+
+// Whether a binding to a T keeps views of the input.
+template <typename T>
+inline constexpr auto keeps_views = std::same_as<T, std::string_view>;
+
+template <typename T>
+inline constexpr auto keeps_views<std::optional<T>> = keeps_views<T>;
+
+template <typename T>
+inline constexpr auto keeps_views<std::vector<T>> = keeps_views<T>;
+
+// Converts the lazy values a binding refers to, for cli::validate_all;
+// check is null for any other binding.
+struct lazy_check {
+    void const* var_ptr = nullptr;
+    auto (*check)(void const* var_ptr) -> std::optional<parse_error> = nullptr;
+};
+
+template <typename T>
+inline auto make_lazy_check(T const& /*var*/) -> lazy_check
+{
+    return {};
+}
+
+template <typename T>
+inline auto make_lazy_check(lazy<T> const& var) -> lazy_check
+{
+    return {&var, [](void const* ptr) {
+                return static_cast<lazy<T> const*>(ptr)->validate();
+            }};
+}
+
+template <typename T>
+inline auto make_lazy_check(std::vector<lazy<T>> const& var) -> lazy_check
+{
+    return {&var, [](void const* ptr) -> std::optional<parse_error> {
+                for (auto const& value :
+                     *static_cast<std::vector<lazy<T>> const*>(ptr)) {
+                    if (auto error = value.validate()) { return error; }
+                }
+                return std::nullopt;
+            }};
 }
 
 class bound_flag {
@@ -80,223 +448,789 @@ class bound_flag {
     void assign(bool x) { *var_ptr = x; }
 };
 
-class bound_value {
-    // NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
-    struct storage_base {
-        virtual ~storage_base() = default;
-        virtual void assign_parsed(std::string_view input) const = 0;
+template <typename T>
+concept bit_word = std::unsigned_integral<T> && !std::same_as<T, bool>;
+
+// Bits of a word many flags share: an unsigned integer, a flags enum or a
+// std::bitset. Setting a flag ORs its mask into the word, which for a
+// bitset is the position of the bit instead.
+class bound_bits {
+    struct operations {
+        void (*assign)(void* var_ptr, std::uint64_t mask, bool x);
+        // Whether masks of the word can be ORed into a single write.
+        bool are_masks;
     };
 
-    template <istreamable T>
-    class storage : public storage_base {
-        T* var_ptr;
+    template <bit_word T>
+    static constexpr auto word_operations = operations{
+        [](void* ptr, std::uint64_t mask, bool x) {
+            auto& word = *static_cast<T*>(ptr);
+            auto const bits = static_cast<T>(mask);
+            word = x ? static_cast<T>(word | bits)
+                     : static_cast<T>(word & static_cast<T>(~bits));
+        },
+        true};
 
-       public:
-        explicit storage(T& var) : var_ptr{&var} {}
+    template <typename E>
+    static constexpr auto enum_operations = operations{
+        [](void* ptr, std::uint64_t mask, bool x) {
+            using word_type = std::make_unsigned_t<std::underlying_type_t<E>>;
+            auto& flags = *static_cast<E*>(ptr);
+            auto const word = static_cast<word_type>(flags);
+            auto const bits = static_cast<word_type>(mask);
+            flags = static_cast<E>(
+                x ? static_cast<word_type>(word | bits)
+                  : static_cast<word_type>(word & static_cast<word_type>(
+                        ~bits)));
+        },
+        true};
 
-        void assign_parsed(std::string_view input) const final
-        {
-            from_string(input, *var_ptr);
-        }
-    };
+    template <std::size_t N>
+    static constexpr auto bitset_operations = operations{
+        [](void* ptr, std::uint64_t pos, bool x) {
+            static_cast<std::bitset<N>*>(ptr)->set(
+                static_cast<std::size_t>(pos),
+                x);
+        },
+        false};
 
-    template <istreamable T>
-        requires std::default_initializable<T>
-    class optional_storage : public storage_base {
-        std::optional<T>* var_ptr;
+    void* var_ptr;
+    std::uint64_t mask;
+    operations const* ops;
 
-       public:
-        explicit optional_storage(std::optional<T>& var) : var_ptr{&var} {}
+   public:
+    template <bit_word T>
+    bound_bits(T& var, T mask)
+        : var_ptr{&var}, mask{mask}, ops{&word_operations<T>}
+    {
+    }
 
-        void assign_parsed(std::string_view input) const final
-        {
-            var_ptr->emplace();
-            from_string(input, **var_ptr);
+    template <typename E>
+        requires std::is_enum_v<E>
+    bound_bits(E& var, E mask)
+        : var_ptr{&var},
+          mask{static_cast<std::make_unsigned_t<std::underlying_type_t<E>>>(
+              mask)},
+          ops{&enum_operations<E>}
+    {
+    }
+
+    template <std::size_t N>
+    bound_bits(std::bitset<N>& var, std::size_t pos)
+        : var_ptr{&var}, mask{pos}, ops{&bitset_operations<N>}
+    {
+    }
+
+    void assign(bool x) { ops->assign(var_ptr, mask, x); }
+
+    // A single write of both, when other sets bits of the same word.
+    auto merged(bound_bits const& other) const -> std::optional<bound_bits>
+    {
+        if (!ops->are_masks || ops != other.ops || var_ptr != other.var_ptr) {
+            return std::nullopt;
         }
-    };
+        auto both = *this;
+        both.mask |= other.mask;
+        return both;
+    }
+};
 
-    std::unique_ptr<storage_base> storage_ptr;
+// Type-erased reference to a variable: a pointer to it and a conversion
+// thunk, both stored inline.
+class bound_value {
+    void* var_ptr;
+    auto (*assign)(void* var_ptr, std::string_view input)
+        -> std::optional<parse_errc>;
 
    public:
-    template <istreamable T>
+    template <bindable T>
     explicit bound_value(T& var)
-        : storage_ptr{std::make_unique<storage<T>>(var)}
+        : var_ptr{&var}, assign{[](void* ptr, std::string_view input) {
+              return from_string(input, *static_cast<T*>(ptr));
+          }}
     {
     }
 
-    template <istreamable T>
+    template <bindable T>
         requires std::default_initializable<T>
     explicit bound_value(std::optional<T>& var)
-        : storage_ptr{std::make_unique<optional_storage<T>>(var)}
+        : var_ptr{&var}, assign{[](void* ptr, std::string_view input) {
+              auto& opt = *static_cast<std::optional<T>*>(ptr);
+              return from_string(input, opt.emplace());
+          }}
+    {
+    }
+
+    auto assign_parsed(std::string_view input) const
+        -> std::optional<parse_errc>
     {
+        return assign(var_ptr, input);
     }
+};
+
+// The first value of a sequence that could not be converted.
+struct conversion_failure {
+    std::size_t idx;
+    parse_errc kind;
+};
 
-    void assign_parsed(std::string_view input) const
+// Converts inputs into elements appended to out, splitting the work between
+// hardware threads once there are enough inputs to pay for them. Each
+// thread converts a contiguous slice and stops at its first bad value, so
+// the failure reported is always the one for the earliest bad input, and
+// out keeps the values before it, just like converting one by one.
+// Exceptions thrown by conversions are rethrown the same way.
+template <typename T>
+inline auto append_parsed_in_parallel(
+    std::span<std::string_view const> inputs,
+    std::vector<T>& out) -> std::optional<conversion_failure>
+{
+    constexpr auto min_slice_size = std::size_t{4096};
+    auto const first = out.size();
+    out.resize(first + inputs.size());
+    auto const max_threads = std::max(
+        std::size_t{1},
+        std::size_t{std::thread::hardware_concurrency()});
+    auto const num_threads =
+        std::clamp(inputs.size() / min_slice_size, std::size_t{1}, max_threads);
+    auto const slice_size = (inputs.size() + num_threads - 1) / num_threads;
+
+    struct failure {
+        std::size_t idx = std::numeric_limits<std::size_t>::max();
+        parse_errc kind = parse_errc::invalid_value;
+        std::exception_ptr error;
+    };
+    auto failures = std::vector<failure>(num_threads);
+    auto const convert_slice = [&](std::size_t slice) {
+        auto const begin = slice * slice_size;
+        auto const end = std::min(begin + slice_size, inputs.size());
+        for (auto i = begin; i < end; ++i) {
+            try {
+                if (auto const kind = from_string(inputs[i], out[first + i])) {
+                    failures[slice] = {i, *kind, nullptr};
+                    return;
+                }
+            }
+            catch (...) {
+                failures[slice] = {
+                    i,
+                    parse_errc::invalid_value,
+                    std::current_exception()};
+                return;
+            }
+        }
+    };
     {
-        storage_ptr->assign_parsed(input);
+        auto threads = std::vector<std::jthread>{};
+        for (auto slice = std::size_t{1}; slice < num_threads; ++slice) {
+            threads.emplace_back(convert_slice, slice);
+        }
+        convert_slice(0);
     }
+    auto const earliest = std::ranges::min_element(failures, {}, &failure::idx);
+    if (earliest->idx == std::numeric_limits<std::size_t>::max()) {
+        return std::nullopt;
+    }
+    out.resize(first + earliest->idx);
+    if (earliest->error) { std::rethrow_exception(earliest->error); }
+    return conversion_failure{earliest->idx, earliest->kind};
+}
+
+// Something every value of a multi-argument can be handed to as soon as it
+// is converted: a callback or an output iterator.
+template <typename Sink, typename T>
+concept value_sink = std::invocable<Sink&, T> || std::output_iterator<Sink, T>;
+
+struct parallel_conversion_t {
 };
 
 class bound_container {
-    // NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
-    struct storage_base {
-        virtual ~storage_base() = default;
-        virtual void push_back_parsed(std::string_view input) const = 0;
-        virtual auto size() const -> std::size_t = 0;
+    struct operations {
+        auto (*push_back_parsed)(void* var_ptr, std::string_view input)
+            -> std::optional<parse_errc>;
+        // Set for containers that want all their values at once.
+        auto (*push_back_all_parsed)(
+            void* var_ptr,
+            std::span<std::string_view const> inputs)
+            -> std::optional<conversion_failure>;
+        // Set for containers that can make room for values in advance.
+        void (*reserve)(void* var_ptr, std::size_t max_size) = nullptr;
     };
 
-    template <istreamable T>
+    template <bindable T>
         requires std::default_initializable<T>
-    class storage : public storage_base {
-        std::vector<T>* var_ptr;
+    static constexpr auto vector_operations = operations{
+        [](void* ptr, std::string_view input) {
+            return from_string(
+                input,
+                static_cast<std::vector<T>*>(ptr)->emplace_back());
+        },
+        nullptr,
+        [](void* ptr, std::size_t max_size) {
+            reserve_more(*static_cast<std::vector<T>*>(ptr), max_size);
+        }};
 
-       public:
-        explicit storage(std::vector<T>& var) : var_ptr{&var} {}
-
-        void push_back_parsed(std::string_view input) const final
-        {
-            from_string(input, var_ptr->emplace_back());
-        }
+    template <bindable T>
+        requires std::default_initializable<T>
+    static constexpr auto parallel_vector_operations = operations{
+        vector_operations<T>.push_back_parsed,
+        [](void* ptr, std::span<std::string_view const> inputs) {
+            return append_parsed_in_parallel(
+                inputs,
+                *static_cast<std::vector<T>*>(ptr));
+        }};
 
-        auto size() const -> std::size_t final { return var_ptr->size(); }
-    };
+    template <bindable T, value_sink<T> Sink>
+        requires std::default_initializable<T>
+    static constexpr auto sink_operations = operations{
+        [](void* ptr, std::string_view input) -> std::optional<parse_errc> {
+            auto value = T{};
+            if (auto const kind = from_string(input, value)) { return kind; }
+            auto& sink = *static_cast<Sink*>(ptr);
+            if constexpr (std::invocable<Sink&, T>) {
+                std::invoke(sink, std::move(value));
+            }
+            else {
+                *sink = std::move(value);
+                ++sink;
+            }
+            return std::nullopt;
+        },
+        nullptr};
 
-    std::unique_ptr<storage_base> storage_ptr;
+    void* var_ptr;
+    operations const* ops;
 
    public:
-    template <istreamable T>
+    template <bindable T>
         requires std::default_initializable<T>
     explicit bound_container(std::vector<T>& var)
-        : storage_ptr{std::make_unique<storage<T>>(var)}
+        : var_ptr{&var}, ops{&vector_operations<T>}
     {
     }
 
-    void push_back_parsed(std::string_view input) const
+    template <bindable T>
+        requires std::default_initializable<T>
+    bound_container(parallel_conversion_t /*unused*/, std::vector<T>& var)
+        : var_ptr{&var}, ops{&parallel_vector_operations<T>}
     {
-        storage_ptr->push_back_parsed(input);
     }
 
-    auto size() const -> std::size_t { return storage_ptr->size(); }
-};
-
-struct option {
-    using bound_variable = std::variant<bound_flag, bound_value>;
+    template <bindable T, value_sink<T> Sink>
+        requires std::default_initializable<T>
+    bound_container(std::type_identity<T> /*unused*/, Sink& sink)
+        : var_ptr{&sink}, ops{&sink_operations<T, Sink>}
+    {
+    }
 
-    bound_variable bound_var;
-    std::string name;
-    std::string shorthand;
+    auto push_back_parsed(std::string_view input) const
+        -> std::optional<parse_errc>
+    {
+        return ops->push_back_parsed(var_ptr, input);
+    }
 
-    auto is_flag() const -> bool
+    // Makes room for up to max_size more values, so that the container
+    // grows at most once while parsing.
+    void reserve(std::size_t max_size) const
     {
-        return std::holds_alternative<bound_flag>(bound_var);
+        if (ops->reserve != nullptr) { ops->reserve(var_ptr, max_size); }
     }
 
-    void write_parsed(std::string_view str)
+    auto wants_all_at_once() const -> bool
     {
-        std::get<bound_value>(bound_var).assign_parsed(str);
+        return ops->push_back_all_parsed != nullptr;
     }
 
-    void write(bool value) { std::get<bound_flag>(bound_var).assign(value); }
+    auto push_back_all_parsed(std::span<std::string_view const> inputs) const
+        -> std::optional<conversion_failure>
+    {
+        return ops->push_back_all_parsed(var_ptr, inputs);
+    }
 };
 
-struct argument {
-    using bound_variable = std::variant<bound_value, bound_container>;
+struct option {
+    using bound_variable = std::variant<bound_flag, bound_value, bound_bits>;
 
     bound_variable bound_var;
-};
+    std::pmr::string name;
+    std::pmr::string shorthand;
+    std::pmr::string env_var;
 
-struct positional_token {
-    std::string value;
-};
+    auto is_flag() const -> bool
+    {
+        return !std::holds_alternative<bound_value>(bound_var);
+    }
 
-struct option_token {
-    std::string name;
-    std::string value;
-    std::size_t option_idx;
-};
+    auto write_parsed(std::string_view str) -> std::optional<parse_errc>
+    {
+        return std::get<bound_value>(bound_var).assign_parsed(str);
+    }
 
-struct flag_token {
-    std::string name;
-    std::size_t flag_idx;
+    void write(bool value)
+    {
+        if (auto* flag = std::get_if<bound_flag>(&bound_var)) {
+            flag->assign(value);
+        }
+        else { std::get<bound_bits>(bound_var).assign(value); }
+    }
 };
 
-using token = std::variant<positional_token, option_token, flag_token>;
-
-class program_arguments_token_view
-    : std::ranges::view_interface<program_arguments_token_view>  //
+// Slot of a "-x" string in a 128-entry shorthand table.
+constexpr auto shorthand_char(std::string_view str)
+    -> std::optional<std::size_t>
 {
-    struct sentinel {
-    };
+    if (str.size() != 2 || str[0] != '-' || str[1] == '-') {
+        return std::nullopt;
+    }
+    auto const c = static_cast<unsigned char>(str[1]);
+    if (c >= 128) { return std::nullopt; }
+    return c;
+}
 
-    class iterator_impl {
-        program_arguments_token_view const* parent;
-        std::vector<std::string>::const_iterator current;
-        std::optional<token> tok;
-        std::vector<flag_token> flags_buffer;
-        bool are_options_terminated = false;
+// Owns the options together with a lookup index over them: a direct table
+// for single-character shorthands and a name-sorted permutation for long
+// names. The index is kept up to date as options are added. Option has to
+// have name and shorthand strings and an is_flag() member.
+template <typename Option>
+class basic_option_table {
+    static constexpr auto npos = std::numeric_limits<std::size_t>::max();
 
-       public:
-        iterator_impl(
-            program_arguments_token_view const* parent,
-            std::vector<std::string>::const_iterator cursor)
-            : parent{parent}, current{cursor}
-        {
-            next();
-        }
+    std::pmr::vector<Option> opts;
+    std::array<std::size_t, 128> by_shorthand = make_shorthand_table();
+    std::pmr::vector<std::size_t> by_name;
 
-        void next()
-        {
-            if (!flags_buffer.empty()) {
-                tok = flags_buffer.back();
-                flags_buffer.pop_back();
-                return;
-            }
-            if (current == parent->strs.end()) {
-                tok.reset();
-                return;
-            }
-            if (*current == "--") {
-                are_options_terminated = true;
-                ++current;
-                if (current == parent->strs.end()) {
-                    tok.reset();
-                    return;
+   public:
+    explicit basic_option_table(
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : opts{resource}, by_name{resource}
+    {
+    }
+
+    // Adds new_opts with a single sort of their names, merged into the name
+    // index, instead of an insertion into it for every option. If that
+    // would define a name or shorthand twice, nothing is added and every
+    // such name is returned, once and in order.
+    auto append(std::span<Option> new_opts)
+        -> std::pmr::vector<std::string_view>
+    {
+        auto const first = opts.size();
+        auto const name_of = [&](std::size_t i) {
+            return std::string_view{
+                i < first ? opts[i].name : new_opts[i - first].name};
+        };
+        auto duplicates =
+            std::pmr::vector<std::string_view>{by_name.get_allocator()};
+        auto shorthands = by_shorthand;
+        auto sorted = std::pmr::vector<std::size_t>{by_name.get_allocator()};
+        sorted.reserve(new_opts.size());
+        for (auto i = std::size_t{0}; i < new_opts.size(); ++i) {
+            if (auto const c = shorthand_char(new_opts[i].shorthand)) {
+                if (shorthands[*c] != npos) {
+                    duplicates.push_back(new_opts[i].shorthand);
                 }
+                shorthands[*c] = first + i;
             }
-            make_next();
-            ++current;
+            sorted.push_back(first + i);
+        }
+        std::ranges::sort(sorted, {}, name_of);
+        auto merged = std::pmr::vector<std::size_t>{by_name.get_allocator()};
+        merged.reserve(by_name.size() + sorted.size());
+        std::ranges::merge(
+            by_name,
+            sorted,
+            std::back_inserter(merged),
+            {},
+            name_of,
+            name_of);
+        for (auto i = std::size_t{1}; i < merged.size(); ++i) {
+            auto const name = name_of(merged[i]);
+            if (name == name_of(merged[i - 1])) { duplicates.push_back(name); }
+        }
+        if (!duplicates.empty()) {
+            std::ranges::sort(duplicates);
+            auto const [last, end] = std::ranges::unique(duplicates);
+            duplicates.erase(last, end);
+            return duplicates;
         }
 
-        auto has_value() const -> bool { return tok.has_value(); }
-
-        auto value() const -> token const& { return *tok; }
-
-       private:
-        struct match_option_result {
-            bool is_flag;
-            std::size_t idx;
-        };
+        reserve_more(opts, new_opts.size());
+        std::ranges::move(new_opts, std::back_inserter(opts));
+        by_name = std::move(merged);
+        by_shorthand = shorthands;
+        return duplicates;
+    }
 
-        auto match_option(std::string_view str) -> match_option_result
-        {
-            auto const it =
-                std::ranges::find_if(*parent->opts, [&](auto const& o) {
-                    return o.shorthand == str || o.name == str;
-                });
-            if (it == parent->opts->end()) {
-                throw parsing_error{join(str, " is not an option")};
-            }
-            return {
-                it->is_flag(),
-                static_cast<std::size_t>(it - parent->opts->begin())};
+    void push_back(Option opt)
+    {
+        auto const idx = opts.size();
+        auto const name_pos = std::ranges::lower_bound(
+            by_name,
+            std::string_view{opt.name},
+            {},
+            [&](std::size_t i) { return std::string_view{opts[i].name}; });
+        if (auto const c = shorthand_char(opt.shorthand)) {
+            by_shorthand[*c] = idx;
         }
+        by_name.insert(name_pos, idx);
+        opts.push_back(std::move(opt));
+    }
 
-        void make_next()
-        {
-            if ((*current)[0] != '-' || are_options_terminated) {
+    auto find(std::string_view str) const -> std::optional<std::size_t>
+    {
+        if (auto const c = shorthand_char(str)) {
+            auto const idx = by_shorthand[*c];
+            if (idx == npos) { return std::nullopt; }
+            return idx;
+        }
+        auto const it = std::ranges::lower_bound(
+            by_name,
+            str,
+            {},
+            [&](std::size_t i) { return std::string_view{opts[i].name}; });
+        if (it == by_name.end() || opts[*it].name != str) {
+            return std::nullopt;
+        }
+        return *it;
+    }
+
+    // Indices of the options whose long name starts with prefix, in name
+    // order. They are adjacent in the name index, so this is a binary search.
+    auto with_prefix(std::string_view prefix) const
+        -> std::span<std::size_t const>
+    {
+        auto const name_of = [&](std::size_t i) {
+            return std::string_view{opts[i].name};
+        };
+        auto const first =
+            std::ranges::lower_bound(by_name, prefix, {}, name_of);
+        auto const last = std::ranges::partition_point(
+            first,
+            by_name.end(),
+            [&](std::size_t i) { return name_of(i).starts_with(prefix); });
+        return {first, last};
+    }
+
+    auto operator[](std::size_t idx) -> Option& { return opts[idx]; }
+
+    auto operator[](std::size_t idx) const -> Option const&
+    {
+        return opts[idx];
+    }
+
+    auto size() const -> std::size_t { return opts.size(); }
+
+    auto begin() const { return opts.begin(); }
+
+    auto end() const { return opts.end(); }
+
+   private:
+    static auto make_shorthand_table() -> std::array<std::size_t, 128>
+    {
+        auto table = std::array<std::size_t, 128>{};
+        table.fill(npos);
+        return table;
+    }
+};
+
+using option_table = basic_option_table<option>;
+
+struct argument {
+    using bound_variable = std::variant<bound_value, bound_container>;
+
+    bound_variable bound_var;
+
+    auto is_multi() const -> bool
+    {
+        return std::holds_alternative<bound_container>(bound_var);
+    }
+
+    auto write_parsed(std::string_view str) const
+        -> std::optional<parse_errc>
+    {
+        return std::visit(
+            overloaded{
+                [&](bound_value const& value) {
+                    return value.assign_parsed(str);
+                },
+                [&](bound_container const& container) {
+                    return container.push_back_parsed(str);
+                }},
+            bound_var);
+    }
+};
+
+// Position of the multi-argument among Args, or its size if there is none.
+template <std::ranges::random_access_range Args>
+inline auto find_multi_argument(Args const& args) -> std::size_t
+{
+    auto const it = std::ranges::find_if(args, [](auto const& arg) {
+        return arg.is_multi();
+    });
+    return static_cast<std::size_t>(it - std::ranges::begin(args));
+}
+
+// Assigns positional values to arguments as they arrive, by calling
+// assign(argument index, value); for the multi-argument it is called once
+// per value. Values past the multi-argument are held back in a ring buffer
+// sized for the arguments that follow it, so memory stays bounded however
+// many values it takes. assign returns the error, if any, that push and
+// finish pass on.
+template <std::invocable<std::size_t, std::string_view> Assign>
+class positional_binder {
+    Assign assign;
+    std::size_t num_args;
+    std::size_t multi_idx;
+    std::size_t next_idx = 0;
+    std::size_t num_multi_values = 0;
+    std::pmr::vector<std::string_view> held_back;
+    std::size_t held_back_begin = 0;
+    std::size_t num_held_back = 0;
+
+   public:
+    positional_binder(
+        std::size_t num_args,
+        std::size_t multi_idx,
+        Assign assign,
+        std::pmr::memory_resource* resource)
+        : assign{std::move(assign)},
+          num_args{num_args},
+          multi_idx{multi_idx},
+          held_back{resource}
+    {
+        if (multi_idx != num_args) {
+            held_back.resize(num_args - multi_idx - 1);
+        }
+    }
+
+    auto push(std::string_view value) -> std::optional<parse_error>
+    {
+        if (next_idx < multi_idx) { return assign(next_idx++, value); }
+        if (multi_idx == num_args) {
+            // Surplus values are ignored when there is no multi-argument.
+            return std::nullopt;
+        }
+        if (held_back.empty()) { return push_to_multi(value); }
+        auto& slot =
+            held_back[(held_back_begin + num_held_back) % held_back.size()];
+        if (num_held_back == held_back.size()) {
+            held_back_begin = (held_back_begin + 1) % held_back.size();
+            return push_to_multi(std::exchange(slot, value));
+        }
+        slot = value;
+        ++num_held_back;
+        return std::nullopt;
+    }
+
+    auto finish() -> std::optional<parse_error>
+    {
+        auto const is_multi_last_and_empty =
+            held_back.empty() && num_multi_values == 0;
+        if (next_idx < multi_idx
+            || num_held_back < held_back.size()
+            || (multi_idx != num_args && is_multi_last_and_empty)) {
+            return parse_error{parse_errc::wrong_number_of_arguments, {}};
+        }
+        for (auto i = std::size_t{0}; i < num_held_back; ++i) {
+            auto const value =
+                held_back[(held_back_begin + i) % held_back.size()];
+            if (auto error = assign(multi_idx + 1 + i, value)) {
+                return error;
+            }
+        }
+        return std::nullopt;
+    }
+
+   private:
+    auto push_to_multi(std::string_view value) -> std::optional<parse_error>
+    {
+        ++num_multi_values;
+        return assign(multi_idx, value);
+    }
+};
+
+struct positional_token {
+    std::string_view value;
+};
+
+struct option_token {
+    std::string_view name;
+    std::string_view value;
+    std::size_t option_idx;
+};
+
+struct flag_token {
+    std::string_view name;
+    std::size_t flag_idx;
+    // The letters after the first of a cluster such as -abc, when this is
+    // its first flag.
+    std::string_view cluster = {};
+};
+
+// Ends the tokens when an argument cannot be tokenized.
+struct error_token {
+    parse_errc kind;
+    std::string_view text;
+    std::size_t option_idx = parse_error::npos;
+    bool is_cluster_letter = false;
+
+    auto error() const -> parse_error
+    {
+        return {kind, text, parse_error::npos, option_idx, is_cluster_letter};
+    }
+};
+
+using token =
+    std::variant<positional_token, option_token, flag_token, error_token>;
+
+// Table has to provide find(std::string_view) -> std::optional<std::size_t>
+// and an operator[] yielding an entry with a shorthand and is_flag().
+template <typename Table>
+class basic_token_view
+    : std::ranges::view_interface<basic_token_view<Table>>  //
+{
+    struct sentinel {
+    };
+
+    // Holds the whole tokenizer state by value, so stepping through the
+    // arguments never allocates. A cluster of short flags (-abc) is kept as
+    // the view of its not yet emitted characters.
+    class iterator {
+        basic_token_view const* parent = nullptr;
+        std::span<std::string_view const>::iterator current;
+        token tok;
+        std::size_t token_position = 0;
+        std::string_view pending_flags;
+        bool is_exhausted = true;
+        bool are_options_terminated = false;
+        bool has_failed = false;
+
+       public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = token;
+
+        iterator() = default;
+
+        iterator(
+            basic_token_view const* parent,
+            std::span<std::string_view const>::iterator cursor)
+            : parent{parent}, current{cursor},
+              are_options_terminated{parent->are_options_terminated}
+        {
+            next();
+        }
+
+        auto operator++() -> iterator&
+        {
+            next();
+            return *this;
+        }
+
+        auto operator++(int) -> iterator
+        {
+            auto temp = *this;
+            next();
+            return temp;
+        }
+
+        auto operator*() const -> value_type const& { return tok; }
+
+        // Index of the string the current token was read from.
+        auto position() const -> std::size_t { return token_position; }
+
+        // Whether a -- was read, so that the remaining strings are
+        // positional arguments.
+        auto options_terminated() const -> bool
+        {
+            return are_options_terminated;
+        }
+
+        // Drops the letters of the current cluster not yet emitted, for a
+        // reader that handled the whole cluster from its first flag.
+        void skip_cluster() { pending_flags = {}; }
+
+        friend auto operator==(iterator const& it, sentinel const&) -> bool
+        {
+            return it.is_exhausted;
+        }
+
+       private:
+        void next()
+        {
+            if (has_failed) {
+                is_exhausted = true;
+                return;
+            }
+            if (!pending_flags.empty()) {
+                process_pending_flag();
+                return;
+            }
+            if (current == parent->strs.end()) {
+                is_exhausted = true;
+                return;
+            }
+            if (*current == "--") {
+                are_options_terminated = true;
+                ++current;
+                if (current == parent->strs.end()) {
+                    is_exhausted = true;
+                    return;
+                }
+            }
+            is_exhausted = false;
+            token_position =
+                static_cast<std::size_t>(current - parent->strs.begin());
+            make_next();
+            ++current;
+        }
+
+        struct match_option_result {
+            bool is_flag;
+            std::size_t idx;
+        };
+
+        // text is what an error reports, str when not given.
+        auto match_option(std::string_view str, std::string_view text = {})
+            -> std::optional<match_option_result>
+        {
+            auto const idx = parent->opts->find(str);
+            if (!idx) {
+                if (text.empty()) {
+                    fail(parse_errc::not_an_option, str);
+                }
+                else {
+                    fail_in_cluster(parse_errc::not_an_option, text);
+                }
+                return std::nullopt;
+            }
+            return match_option_result{(*parent->opts)[*idx].is_flag(), *idx};
+        }
+
+        void fail(
+            parse_errc kind,
+            std::string_view text,
+            std::size_t option_idx = parse_error::npos)
+        {
+            tok = error_token{kind, text, option_idx};
+            pending_flags = {};
+            has_failed = true;
+        }
+
+        void fail_in_cluster(
+            parse_errc kind,
+            std::string_view letter,
+            std::size_t option_idx = parse_error::npos)
+        {
+            fail(kind, letter, option_idx);
+            std::get<error_token>(tok).is_cluster_letter = true;
+        }
+
+        void make_next()
+        {
+            if (!current->starts_with('-') || are_options_terminated) {
                 tok = positional_token{*current};
             }
-            else if ((*current)[1] != '-') {
+            else if (!current->starts_with("--")) {
                 process_single_dash_string();
             }
             else {
@@ -308,8 +1242,16 @@ class program_arguments_token_view
         {
             if (current->length() > 2) {
                 auto const name = current->substr(0, 2);
-                auto const [is_flag, idx] = match_option(name);
-                if (is_flag) { process_adjacent_flags(idx); }
+                auto const match = match_option(name);
+                if (!match) { return; }
+                auto const [is_flag, idx] = *match;
+                if (is_flag) {
+                    pending_flags = current->substr(2);
+                    tok = flag_token{
+                        (*parent->opts)[idx].shorthand,
+                        idx,
+                        pending_flags};
+                }
                 else {
                     auto const value = current->substr(2);
                     tok = option_token{name, value, idx};
@@ -335,107 +1277,76 @@ class program_arguments_token_view
         {
             auto const name = current->substr(0, pos);
             auto const value = current->substr(pos + 1);
-            auto const [is_flag, idx] = match_option(name);
-            if (is_flag) {
-                throw parsing_error{join(*current, " is invalid")};
+            auto const match = match_option(name);
+            if (!match) { return; }
+            if (match->is_flag) {
+                fail(parse_errc::flag_with_value, *current, match->idx);
+                return;
             }
-            tok = option_token{name, value, idx};
+            tok = option_token{name, value, match->idx};
         }
 
         void process_regular_option()
         {
-            auto const [is_flag, idx] = match_option(*current);
+            auto const match = match_option(*current);
+            if (!match) { return; }
+            auto const [is_flag, idx] = *match;
             if (is_flag) { tok = flag_token{*current, idx}; }
             else {
                 auto const name = *current;
-                if (++current == parent->strs.end()) {
-                    throw parsing_error{
-                        join(name, " is missing an argument")};
+                if (current + 1 == parent->strs.end()) {
+                    fail(parse_errc::missing_value, name, idx);
+                    return;
                 }
-                tok = option_token{name, *current, idx};
+                tok = option_token{name, *++current, idx};
             }
         }
 
-        void process_adjacent_flags(std::size_t idx)
+        // Errors name the letter within the cluster, as the "-x" looked up
+        // is not part of the input.
+        void process_pending_flag()
         {
-            for (auto const f :
-                 *current | std::views::drop(1) | std::views::reverse) {
-                auto name = "- "s;
-                name[1] = f;
-                auto const [is_flag, idx_] = match_option(name);
-                if (!is_flag) {
-                    throw parsing_error{
-                        join(name, " is not a flag")};
-                }
-                flags_buffer.emplace_back(name, idx_);
+            auto const letter = pending_flags.substr(0, 1);
+            auto const name = std::array{'-', letter.front()};
+            auto const match =
+                match_option({name.data(), name.size()}, letter);
+            if (!match) { return; }
+            if (!match->is_flag) {
+                fail_in_cluster(parse_errc::not_a_flag, letter, match->idx);
+                return;
             }
-            tok = flag_token{current->substr(2), idx};
+            tok = flag_token{(*parent->opts)[match->idx].shorthand, match->idx};
+            pending_flags.remove_prefix(1);
         }
     };
 
-    class iterator {
-        std::shared_ptr<iterator_impl> pimpl;
-
-       public:
-        using iterator_category = std::input_iterator_tag;
-        using difference_type = std::ptrdiff_t;
-        using value_type = token;
-
-        iterator() = default;
-
-        iterator(
-            program_arguments_token_view const* parent,
-            std::vector<std::string>::const_iterator cursor)
-            : pimpl{std::make_shared<iterator_impl>(parent, cursor)}
-        {
-        }
-
-        auto operator++() -> iterator&
-        {
-            cow();
-            pimpl->next();
-            return *this;
-        }
-
-        auto operator++(int) -> iterator
-        {
-            auto temp = *this;
-            ++(*this);
-            return temp;
-        }
-
-        auto operator*() const -> value_type { return pimpl->value(); }
-
-        friend auto operator==(iterator const& it, sentinel const&) -> bool
-        {
-            return !it.pimpl->has_value();
-        }
-
-       private:
-        void cow()
-        {
-            if (pimpl.use_count() > 1) {
-                pimpl = std::make_shared<iterator_impl>(*pimpl);
-            }
-        }
-    };
+    std::span<std::string_view const> strs;
+    Table const* opts;
 
-    std::vector<std::string> strs;
-    std::vector<option> const* opts;
+    bool are_options_terminated;
 
    public:
-    program_arguments_token_view(
-        std::vector<std::string> strs,
-        std::vector<option> const& opts)
-        : strs{std::move(strs)}, opts{&opts}
+    // With are_options_terminated, as after a --, every string is a
+    // positional argument.
+    basic_token_view(
+        std::span<std::string_view const> strs,
+        Table const& opts,
+        bool are_options_terminated = false)
+        : strs{strs}, opts{&opts},
+          are_options_terminated{are_options_terminated}
     {
     }
 
     auto begin() const { return iterator{this, strs.begin()}; }
 
     auto end() const { return sentinel{}; }
+
+    // Each string is at most one token of a value.
+    auto max_values() const -> std::size_t { return strs.size(); }
 };
 
+using program_arguments_token_view = basic_token_view<option_table>;
+
 inline void validate_option_name(std::string_view name)
 {
     if (name.size() < 3 || name.substr(0, 2) != "--") {
@@ -451,8 +1362,10 @@ inline void validate_option_name(std::string_view name)
     }
 }
 
+// An empty shorthand stands for none.
 inline void validate_option_shorthand(std::string_view shorthand)
 {
+    if (shorthand.empty()) { return; }
     if (shorthand.size() != 2 || shorthand[0] != '-') {
         throw invalid_cli_definition{
             "Option shorthand has to start with - and one character"};
@@ -462,106 +1375,2440 @@ inline void validate_option_shorthand(std::string_view shorthand)
     }
 }
 
+template <typename Option>
 inline void validate_uniqueness(
     std::string_view name,
     std::string_view shorthand,
-    std::vector<option> const& opts)
+    basic_option_table<Option> const& opts)
 {
-    for (auto const& o : opts) {
-        if (o.name == name) {
-            throw invalid_cli_definition{join(name, " is already defined")};
-        }
-        if (o.shorthand == shorthand) {
-            throw invalid_cli_definition{
-                join(shorthand, " is already defined")};
-        }
+    if (opts.find(name)) {
+        throw invalid_cli_definition{join(name, " is already defined")};
+    }
+    if (!shorthand.empty() && opts.find(shorthand)) {
+        throw invalid_cli_definition{join(shorthand, " is already defined")};
     }
 }
 
+template <typename Option>
 inline void validate_option_specification(
     std::string_view name,
     std::string_view shorthand,
-    std::vector<option> const& opts)
+    basic_option_table<Option> const& opts)
 {
     validate_option_name(name);
     validate_option_shorthand(shorthand);
     validate_uniqueness(name, shorthand, opts);
 }
 
+inline auto environment() -> char const* const*
+{
+#if defined(_WIN32)
+    return _environ;
+#elif defined(__APPLE__)
+    return *_NSGetEnviron();
+#else
+    return ::environ;
+#endif
+}
+
+struct string_hash {
+    using is_transparent = void;
+
+    auto operator()(std::string_view str) const noexcept -> std::size_t
+    {
+        return std::hash<std::string_view>{}(str);
+    }
+};
+
+// Maps environment variable names to option indices.
+using environment_index = std::pmr::unordered_map<
+    std::pmr::string,
+    std::size_t,
+    string_hash,
+    std::equal_to<>>;
+
+// "--log-level" with prefix "APP_" is read from APP_LOG_LEVEL.
+inline auto environment_variable_name(
+    std::string_view prefix,
+    std::string_view option_name,
+    std::pmr::memory_resource* resource) -> std::pmr::string
+{
+    auto result = std::pmr::string{prefix, resource};
+    for (auto const c : option_name.substr(2)) {
+        result.push_back(
+            c == '-' ? '_'
+                     : static_cast<char>(
+                         std::toupper(static_cast<unsigned char>(c))));
+    }
+    return result;
+}
+
+inline void validate_environment_variable(std::string_view env_var)
+{
+    if (env_var.empty() || env_var.find('=') != std::string_view::npos) {
+        throw invalid_cli_definition{
+            join(env_var, " is not a valid environment variable name")};
+    }
+}
+
+// Flag values as written in the environment or a config file.
+inline auto parse_flag_value(std::string_view value) -> std::optional<bool>
+{
+    if (value == "1" || value == "true" || value == "yes" || value == "on") {
+        return true;
+    }
+    if (value.empty() || value == "0" || value == "false" || value == "no"
+        || value == "off") {
+        return false;
+    }
+    return std::nullopt;
+}
+
+// Whether part views into the characters of whole.
+inline auto is_view_into(std::string_view whole, std::string_view part)
+    -> bool
+{
+    auto const less_equal = std::less_equal<char const*>{};
+    return less_equal(whole.data(), part.data())
+           && less_equal(
+               part.data() + part.size(),
+               whole.data() + whole.size());
+}
+
+// Sets the argv index of an error from the argument its text views into,
+// strs being argv without the program name. Only errors pay for the search.
+inline void locate(std::span<std::string_view const> strs, parse_error& error)
+{
+    if (error.argv_index != parse_error::npos || error.text.empty()) {
+        return;
+    }
+    auto const it = std::ranges::find_if(strs, [&](std::string_view str) {
+        return is_view_into(str, error.text);
+    });
+    if (it != strs.end()) {
+        error.argv_index = static_cast<std::size_t>(it - strs.begin()) + 1;
+    }
+}
+
 }  // namespace detail
 
-struct multi_t {
+enum class completion_shell {
+    bash,
+    zsh,
+    fish,
 };
 
-inline constexpr auto multi = multi_t{};
+enum class response_file_format {
+    // Whitespace separated, with '', "" and \ quoting as in GCC and MSVC.
+    whitespace,
+    // Every argument terminated by a NUL character, as find -print0 writes.
+    nul_separated,
+};
 
-class cli {
-    std::vector<detail::option> opts;
-    std::vector<detail::argument> args;
-    bool has_multi_argument = false;
+namespace detail {
 
+// Private, writable view of a file's contents. Writes are never carried
+// back to the file; they let response files be unquoted in place.
+class mapped_file {
+#if LIBCLI_HAS_MMAP
    public:
-    void add_option(bool& var, std::string name, std::string shorthand)
+    using file_id = std::pair<dev_t, ino_t>;
+
+   private:
+    char* data = nullptr;
+    std::size_t size = 0;
+    file_id id{};
+
+    mapped_file() = default;
+
+    auto map(std::string const& path) -> bool
     {
-        add_option_impl(
-            detail::bound_flag{var},
-            std::move(name),
-            std::move(shorthand));
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+        auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) { return false; }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        id = {st.st_dev, st.st_ino};
+        size = static_cast<std::size_t>(st.st_size);
+        if (size != 0) {
+            auto* const addr = ::mmap(
+                nullptr,
+                size,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE,
+                fd,
+                0);
+            if (addr == MAP_FAILED) {
+                size = 0;
+                ::close(fd);
+                return false;
+            }
+            data = static_cast<char*>(addr);
+        }
+        ::close(fd);
+        return true;
     }
 
-    template <istreamable T>
-    void add_option(T& var, std::string name, std::string shorthand)
+   public:
+    explicit mapped_file(std::string const& path)
     {
-        add_option_impl(
-            detail::bound_value{var},
-            std::move(name),
-            std::move(shorthand));
+        if (!map(path)) { throw parsing_error{join(path, " cannot be read")}; }
     }
 
-    template <istreamable T>
-        requires std::default_initializable<T>
-    void add_option(
-        std::optional<T>& var,
-        std::string name,
-        std::string shorthand)
+    // The file at path, or nothing if it cannot be read.
+    static auto open(std::string const& path) -> std::optional<mapped_file>
     {
-        add_option_impl(
-            detail::bound_value{var},
-            std::move(name),
-            std::move(shorthand));
+        auto file = mapped_file{};
+        if (!file.map(path)) { return std::nullopt; }
+        return file;
     }
 
-    template <istreamable T>
-    void add_argument(T& var)
+    mapped_file(mapped_file&& other) noexcept
+        : data{std::exchange(other.data, nullptr)},
+          size{std::exchange(other.size, 0)},
+          id{other.id}
     {
-        args.emplace_back(detail::bound_value{var});
     }
 
-    template <istreamable T>
-        requires std::default_initializable<T>
-    void add_argument(multi_t, std::vector<T>& var)
+    mapped_file(mapped_file const&) = delete;
+    auto operator=(mapped_file const&) -> mapped_file& = delete;
+
+    auto operator=(mapped_file&& other) noexcept -> mapped_file&
+    {
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+        std::swap(id, other.id);
+        return *this;
+    }
+
+    ~mapped_file()
+    {
+        if (data != nullptr) { ::munmap(data, size); }
+    }
+
+    auto contents() const -> std::span<char> { return {data, size}; }
+
+    auto identity() const -> file_id const& { return id; }
+#else
+   public:
+    using file_id = std::filesystem::path;
+
+   private:
+    std::unique_ptr<char[]> data;
+    std::size_t size = 0;
+    file_id id;
+
+    mapped_file() = default;
+
+    auto map(std::string const& path) -> bool
+    {
+        auto ec = std::error_code{};
+        id = std::filesystem::canonical(path, ec);
+        auto file = std::ifstream{path, std::ios::binary};
+        if (ec || !file) { return false; }
+        size = static_cast<std::size_t>(std::filesystem::file_size(id, ec));
+        data = std::make_unique<char[]>(size);
+        return !ec
+               && file.read(data.get(), static_cast<std::streamsize>(size));
+    }
+
+   public:
+    explicit mapped_file(std::string const& path)
+    {
+        if (!map(path)) { throw parsing_error{join(path, " cannot be read")}; }
+    }
+
+    // The file at path, or nothing if it cannot be read.
+    static auto open(std::string const& path) -> std::optional<mapped_file>
+    {
+        auto file = mapped_file{};
+        if (!file.map(path)) { return std::nullopt; }
+        return file;
+    }
+
+    auto contents() const -> std::span<char> { return {data.get(), size}; }
+
+    auto identity() const -> file_id const& { return id; }
+#endif
+};
+
+inline auto is_response_file_space(char c) -> bool
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v'
+           || c == '\f';
+}
+
+inline auto is_response_file_special(char c) -> bool
+{
+    return is_response_file_space(c) || c == '\'' || c == '"' || c == '\\';
+}
+
+// Finds the end of a run of characters that are copied as they are: the
+// first whitespace, quote or backslash. With SSE2, sixteen characters are
+// checked at a time.
+inline auto find_response_file_special(char* first, char* last) -> char*
+{
+#if LIBCLI_HAS_SSE2
+    auto const space = _mm_set1_epi8(' ');
+    auto const single_quote = _mm_set1_epi8('\'');
+    auto const double_quote = _mm_set1_epi8('"');
+    auto const backslash = _mm_set1_epi8('\\');
+    auto const tab = _mm_set1_epi8('\t');
+    auto const four = _mm_set1_epi8(4);
+    for (; last - first >= 16; first += 16) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i*>(first));
+        // \t, \n, \v, \f and \r are the five characters from \t on.
+        auto const control = _mm_sub_epi8(chunk, tab);
+        auto const is_control =
+            _mm_cmpeq_epi8(_mm_min_epu8(control, four), control);
+        auto const is_quote = _mm_or_si128(
+            _mm_cmpeq_epi8(chunk, single_quote),
+            _mm_cmpeq_epi8(chunk, double_quote));
+        auto const is_special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space), is_control),
+            _mm_or_si128(is_quote, _mm_cmpeq_epi8(chunk, backslash)));
+        auto const mask =
+            static_cast<unsigned>(_mm_movemask_epi8(is_special));
+        if (mask != 0) { return first + std::countr_zero(mask); }
+    }
+#endif
+    return std::find_if(first, last, is_response_file_special);
+}
+
+// Splits the buffer into arguments, removing quotes and escapes by moving
+// the remaining bytes down within the buffer itself. Stops at the first
+// error output returns.
+template <std::invocable<std::string_view> Output>
+inline auto split_response_file(
+    std::span<char> buffer,
+    response_file_format format,
+    Output output) -> std::optional<parse_errc>
+{
+    auto* const end = buffer.data() + buffer.size();
+    if (format == response_file_format::nul_separated) {
+        auto rest = std::string_view{buffer.data(), buffer.size()};
+        while (!rest.empty()) {
+            auto const nul = std::min(rest.find('\0'), rest.size());
+            if (auto const kind = output(rest.substr(0, nul))) {
+                return kind;
+            }
+            rest.remove_prefix(std::min(nul + 1, rest.size()));
+        }
+        return std::nullopt;
+    }
+    auto* read = buffer.data();
+    while (read != end) {
+        if (is_response_file_space(*read)) {
+            ++read;
+            continue;
+        }
+        auto* const begin = read;
+        auto* write = read;
+        auto quote = '\0';
+        for (; read != end; ++read) {
+            auto* const plain_end = find_response_file_special(read, end);
+            write = write == read ? plain_end
+                                  : std::copy(read, plain_end, write);
+            read = plain_end;
+            if (read == end) { break; }
+            auto const c = *read;
+            if (quote == '\0' && is_response_file_space(c)) { break; }
+            if (c == '\\' && quote != '\'' && read + 1 != end) {
+                *write++ = *++read;
+            }
+            else if (quote == '\0' && (c == '\'' || c == '"')) {
+                quote = c;
+            }
+            else if (c == quote) {
+                quote = '\0';
+            }
+            else {
+                *write++ = c;
+            }
+        }
+        if (quote != '\0') { return parse_errc::unterminated_quote; }
+        if (auto const kind = output(std::string_view{begin, write})) {
+            return kind;
+        }
+    }
+    return std::nullopt;
+}
+
+// Replaces every @path argument with the arguments read from that file,
+// recursively. Expansion stops at the options terminator, and a file that
+// includes itself, directly or not, is an error.
+class response_file_expander {
+    response_file_format format;
+    std::pmr::vector<std::string_view>* out;
+    std::pmr::vector<mapped_file>* files;
+    std::pmr::vector<mapped_file::file_id> open_files;
+    bool are_options_terminated = false;
+
+   public:
+    response_file_expander(
+        response_file_format format,
+        std::pmr::vector<std::string_view>& out,
+        std::pmr::vector<mapped_file>& files)
+        : format{format},
+          out{&out},
+          files{&files},
+          open_files{out.get_allocator()}
+    {
+    }
+
+    auto expand(std::string_view arg) -> std::optional<parse_errc>
+    {
+        if (are_options_terminated || !arg.starts_with('@')) {
+            are_options_terminated = are_options_terminated || arg == "--";
+            out->push_back(arg);
+            return std::nullopt;
+        }
+        auto file = mapped_file::open(std::string{arg.substr(1)});
+        if (!file) { return parse_errc::unreadable_response_file; }
+        if (std::ranges::find(open_files, file->identity())
+            != open_files.end()) {
+            return parse_errc::recursive_response_file;
+        }
+        auto const contents = files->emplace_back(std::move(*file)).contents();
+        open_files.push_back(files->back().identity());
+        auto const kind = split_response_file(
+            contents,
+            format,
+            [this](std::string_view nested) { return expand(nested); });
+        open_files.pop_back();
+        return kind;
+    }
+};
+
+inline auto is_config_space(char c) -> bool
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline auto trim_config_space(std::string_view str) -> std::string_view
+{
+    while (!str.empty() && is_config_space(str.front())) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && is_config_space(str.back())) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+// Shell function names derived from a program name.
+inline auto completion_function_name(std::string_view program) -> std::string
+{
+    auto result = std::string{"_"};
+    for (auto const c : program) {
+        result.push_back(
+            std::isalnum(static_cast<unsigned char>(c)) != 0 ? c : '_');
+    }
+    return result + "_complete";
+}
+
+struct help_doc {
+    std::pmr::string description;
+    std::pmr::string placeholder;
+};
+
+// Columns of the terminal standard output is written to: $COLUMNS, then
+// the terminal itself, then 80.
+inline auto terminal_width() -> std::size_t
+{
+    auto width = std::size_t{0};
+    if (auto const* const columns = std::getenv("COLUMNS")) {
+        auto const str = std::string_view{columns};
+        std::from_chars(str.data(), str.data() + str.size(), width);
+    }
+#if LIBCLI_HAS_MMAP
+    if (width == 0) {
+        auto size = winsize{};
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+        if (::ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) {
+            width = size.ws_col;
+        }
+    }
+#endif
+    return width == 0 ? 80 : width;
+}
+
+// Appends text starting at column, breaking lines between words so they
+// fit in width columns and indenting the lines after the first to indent.
+// Newlines in text are kept; words longer than a line are not broken.
+inline void append_wrapped(
+    std::pmr::string& out,
+    std::string_view text,
+    std::size_t column,
+    std::size_t indent,
+    std::size_t width)
+{
+    auto is_line_start = true;
+    while (!text.empty()) {
+        if (text.front() == ' ') {
+            text.remove_prefix(1);
+            continue;
+        }
+        if (text.front() == '\n') {
+            text.remove_prefix(1);
+            out.push_back('\n');
+            out.append(indent, ' ');
+            column = indent;
+            is_line_start = true;
+            continue;
+        }
+        auto const word = text.substr(0, text.find_first_of(" \n"));
+        text.remove_prefix(word.size());
+        auto const needed = word.size() + (is_line_start ? 0 : 1);
+        if (!is_line_start && column + needed > width) {
+            out.push_back('\n');
+            out.append(indent, ' ');
+            column = indent;
+        }
+        else if (!is_line_start) {
+            out.push_back(' ');
+            ++column;
+        }
+        out.append(word);
+        column += word.size();
+        is_line_start = false;
+    }
+}
+
+// Calls entry(line, section, key, value) for every "key = value" line of
+// text. Lines starting with # or ; are comments and "[section]" lines start
+// a section. Values may be wrapped in double quotes. Everything passed to
+// entry views text.
+template <std::invocable<
+    std::size_t,
+    std::string_view,
+    std::string_view,
+    std::string_view> Entry>
+void read_config(std::string_view text, std::string_view path, Entry entry)
+{
+    auto section = std::string_view{};
+    auto line_number = std::size_t{0};
+    while (!text.empty()) {
+        auto const end = text.find('\n');
+        auto line = trim_config_space(text.substr(0, end));
+        text.remove_prefix(end == std::string_view::npos ? text.size()
+                                                         : end + 1);
+        ++line_number;
+        if (line.empty() || line.starts_with('#') || line.starts_with(';')) {
+            continue;
+        }
+        auto const error = [&](std::string_view what) {
+            return parsing_error{
+                join(path, ":", line_number, ": ", line, what)};
+        };
+        if (line.starts_with('[')) {
+            if (!line.ends_with(']')) {
+                throw error(" is not a valid section");
+            }
+            section = trim_config_space(line.substr(1, line.size() - 2));
+            continue;
+        }
+        auto const pos = line.find('=');
+        if (pos == std::string_view::npos) {
+            throw error(" is not a key = value pair");
+        }
+        auto const key = trim_config_space(line.substr(0, pos));
+        auto value = trim_config_space(line.substr(pos + 1));
+        if (value.size() >= 2 && value.starts_with('"')
+            && value.ends_with('"')) {
+            value = value.substr(1, value.size() - 2);
+        }
+        entry(line_number, section, key, value);
+    }
+}
+
+}  // namespace detail
+
+struct multi_t {
+};
+
+inline constexpr auto multi = multi_t{};
+
+// Like multi, but the values are collected first and converted by several
+// threads at once. Worth it for arguments taking very many values.
+struct parallel_multi_t {
+};
+
+inline constexpr auto parallel_multi = parallel_multi_t{};
+
+// A bit of a variable for a flag, so that many flags can share one word:
+//     cli.add_option(libcli::bit(features, 3), "--fast", "-f");
+class flag_bit {
+    friend class cli;
+    friend class option_definition;
+
+    detail::bound_bits flag;
+
+   public:
+    explicit flag_bit(detail::bound_bits flag) : flag{flag} {}
+};
+
+// Bit pos of an unsigned integer.
+template <detail::bit_word T>
+inline auto bit(T& var, std::size_t pos) -> flag_bit
+{
+    if (pos >= std::numeric_limits<T>::digits) {
+        throw invalid_cli_definition{"Bit position is out of range"};
+    }
+    return flag_bit{detail::bound_bits{var, static_cast<T>(T{1} << pos)}};
+}
+
+// The bits of mask, an enumerator of a flags enum, in var.
+template <typename E>
+    requires std::is_enum_v<E>
+inline auto bit(E& var, E mask) -> flag_bit
+{
+    if (static_cast<std::underlying_type_t<E>>(mask) == 0) {
+        throw invalid_cli_definition{"A flag needs a mask with a bit set"};
+    }
+    return flag_bit{detail::bound_bits{var, mask}};
+}
+
+template <std::size_t N>
+inline auto bit(std::bitset<N>& var, std::size_t pos) -> flag_bit
+{
+    if (pos >= N) {
+        throw invalid_cli_definition{"Bit position is out of range"};
+    }
+    return flag_bit{detail::bound_bits{var, pos}};
+}
+
+// The parts of a parse an observer is told the start and end of. Arguments
+// covers tokenizing, writing options and binding positional arguments, as
+// they happen in a single pass; collected arguments is the conversion of a
+// multi-argument that takes its values all at once.
+enum class parse_phase {
+    response_files,
+    environment,
+    arguments,
+    collected_arguments
+};
+
+inline constexpr auto num_parse_phases = std::size_t{4};
+
+enum class token_kind { positional, option, flag };
+
+inline constexpr auto num_token_kinds = std::size_t{3};
+
+enum class binding_kind { option, argument };
+
+// Is told what a parse does. This one ignores everything; an observer
+// derives from it, hides the members it is interested in, and is passed to
+// cli::parse or cli::try_parse. The calls are resolved at compile time, so
+// a parse without an observer pays nothing for them.
+struct parse_observer {
+    void on_phase_begin(parse_phase /*phase*/) {}
+    void on_phase_end(parse_phase /*phase*/) {}
+    void on_token(token_kind /*kind*/) {}
+
+    // count values were converted for the option or argument idx of the cli
+    // being parsed; has_failed is whether the last one was rejected.
+    void on_conversions(
+        binding_kind /*kind*/,
+        std::size_t /*idx*/,
+        std::size_t /*count*/,
+        bool /*has_failed*/)
+    {
+    }
+
+    // An option or command name that is not defined.
+    void on_unknown_name(std::string_view /*name*/) {}
+
+    // The resource the parse allocates from, given the one it would use.
+    // Called once per parse, subcommands included.
+    auto wrap_resource(std::pmr::memory_resource* upstream)
+        -> std::pmr::memory_resource*
+    {
+        return upstream;
+    }
+};
+
+namespace detail {
+
+// Counts what is allocated from upstream through it.
+class counting_resource : public std::pmr::memory_resource {
+   public:
+    std::pmr::memory_resource* upstream = std::pmr::get_default_resource();
+    std::size_t num_allocations = 0;
+    std::size_t num_bytes = 0;
+
+   private:
+    auto do_allocate(std::size_t bytes, std::size_t alignment)
+        -> void* override
+    {
+        ++num_allocations;
+        num_bytes += bytes;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment)
+        override
+    {
+        upstream->deallocate(ptr, bytes, alignment);
+    }
+
+    auto do_is_equal(std::pmr::memory_resource const& other) const noexcept
+        -> bool override
+    {
+        return this == &other;
+    }
+};
+
+}  // namespace detail
+
+// Records how long each phase took and what the parse did. Subcommands are
+// parsed with the same observer, so their phases nest in arguments, and
+// their conversions are counted by their own option and argument indices.
+class parse_statistics : public parse_observer {
+    using clock = std::chrono::steady_clock;
+
+    std::array<clock::time_point, num_parse_phases> starts{};
+    std::array<std::size_t, num_parse_phases> depths{};
+    detail::counting_resource allocations;
+
+   public:
+    std::array<clock::duration, num_parse_phases> durations{};
+    std::array<std::size_t, num_token_kinds> tokens{};
+    std::vector<std::size_t> option_conversions;
+    std::vector<std::size_t> argument_conversions;
+    std::size_t failed_conversions = 0;
+    std::size_t failed_lookups = 0;
+
+    auto duration(parse_phase phase) const -> clock::duration
+    {
+        return durations[static_cast<std::size_t>(phase)];
+    }
+
+    auto num_tokens(token_kind kind) const -> std::size_t
+    {
+        return tokens[static_cast<std::size_t>(kind)];
+    }
+
+    // Allocations made for the parses, not by the bound variables.
+    auto num_allocations() const -> std::size_t
+    {
+        return allocations.num_allocations;
+    }
+
+    auto allocated_bytes() const -> std::size_t
+    {
+        return allocations.num_bytes;
+    }
+
+    // A phase nested in itself, as in subcommands, is timed once.
+    void on_phase_begin(parse_phase phase)
+    {
+        auto const idx = static_cast<std::size_t>(phase);
+        if (depths[idx]++ == 0) { starts[idx] = clock::now(); }
+    }
+
+    void on_phase_end(parse_phase phase)
+    {
+        auto const idx = static_cast<std::size_t>(phase);
+        if (--depths[idx] == 0) {
+            durations[idx] += clock::now() - starts[idx];
+        }
+    }
+
+    void on_token(token_kind kind) { ++tokens[static_cast<std::size_t>(kind)]; }
+
+    void on_conversions(
+        binding_kind kind,
+        std::size_t idx,
+        std::size_t count,
+        bool has_failed)
+    {
+        auto& counts = kind == binding_kind::option ? option_conversions
+                                                    : argument_conversions;
+        if (counts.size() <= idx) { counts.resize(idx + 1); }
+        counts[idx] += count;
+        failed_conversions += has_failed ? 1 : 0;
+    }
+
+    void on_unknown_name(std::string_view /*name*/) { ++failed_lookups; }
+
+    auto wrap_resource(std::pmr::memory_resource* upstream)
+        -> std::pmr::memory_resource*
+    {
+        allocations.upstream = upstream;
+        return &allocations;
+    }
+};
+
+namespace detail {
+
+// Tells an observer about the start and the end of a phase, including when
+// the phase ends with an exception.
+template <typename Observer>
+class observed_phase {
+    Observer* observer;
+    parse_phase phase;
+
+   public:
+    observed_phase(Observer& observer, parse_phase phase)
+        : observer{&observer}, phase{phase}
+    {
+        observer.on_phase_begin(phase);
+    }
+
+    observed_phase(observed_phase const&) = delete;
+    auto operator=(observed_phase const&) -> observed_phase& = delete;
+
+    ~observed_phase() { observer->on_phase_end(phase); }
+};
+
+}  // namespace detail
+
+#if LIBCLI_HAS_USDT
+// Turns the events into USDT probes of the provider libcli, for perf,
+// bpftrace or SystemTap:
+//     perf probe -x ./app sdt_libcli:phase_begin
+// A probe that is not enabled costs a single nop.
+struct usdt_observer : parse_observer {
+    void on_phase_begin(parse_phase phase)
+    {
+        STAP_PROBE1(libcli, phase_begin, static_cast<int>(phase));
+    }
+
+    void on_phase_end(parse_phase phase)
+    {
+        STAP_PROBE1(libcli, phase_end, static_cast<int>(phase));
+    }
+
+    void on_token(token_kind kind)
+    {
+        STAP_PROBE1(libcli, token, static_cast<int>(kind));
+    }
+
+    void on_conversions(
+        binding_kind kind,
+        std::size_t idx,
+        std::size_t count,
+        bool has_failed)
+    {
+        STAP_PROBE4(
+            libcli,
+            conversions,
+            static_cast<int>(kind),
+            idx,
+            count,
+            static_cast<int>(has_failed));
+    }
+
+    void on_unknown_name(std::string_view name)
+    {
+        STAP_PROBE2(libcli, unknown_name, name.data(), name.size());
+    }
+};
+#endif
+
+// One option for cli::add_options:
+//     cli.add_options({{verbose, "--verbose", "-v"}, {port, "--port"}});
+class option_definition {
+    friend class cli;
+
+    detail::option::bound_variable var;
+    detail::lazy_check lazy_check;
+    bool keeps_views = false;
+    std::string_view name;
+    std::string_view shorthand;
+    std::string_view env_var;
+    std::string_view description;
+    std::string_view placeholder;
+
+   public:
+    option_definition(
+        bool& var,
+        std::string_view name,
+        std::string_view shorthand = {},
+        std::string_view env_var = {})
+        : var{detail::bound_flag{var}}, name{name}, shorthand{shorthand},
+          env_var{env_var}
+    {
+    }
+
+    option_definition(
+        flag_bit bit,
+        std::string_view name,
+        std::string_view shorthand = {},
+        std::string_view env_var = {})
+        : var{bit.flag}, name{name}, shorthand{shorthand}, env_var{env_var}
+    {
+    }
+
+    template <bindable T>
+    option_definition(
+        T& var,
+        std::string_view name,
+        std::string_view shorthand = {},
+        std::string_view env_var = {})
+        : var{detail::bound_value{var}},
+          lazy_check{detail::make_lazy_check(var)},
+          keeps_views{detail::keeps_views<T>}, name{name},
+          shorthand{shorthand}, env_var{env_var}
+    {
+    }
+
+    template <bindable T>
+        requires std::default_initializable<T>
+    option_definition(
+        std::optional<T>& var,
+        std::string_view name,
+        std::string_view shorthand = {},
+        std::string_view env_var = {})
+        : var{detail::bound_value{var}}, keeps_views{detail::keeps_views<T>},
+          name{name}, shorthand{shorthand}, env_var{env_var}
+    {
+    }
+
+    // Same as help_entry::describe; the strings have to outlive the call to
+    // add_options.
+    auto describe(
+        std::string_view description,
+        std::string_view placeholder = {}) -> option_definition&
+    {
+        this->description = description;
+        this->placeholder = placeholder;
+        return *this;
+    }
+};
+
+// Definitions are allocated from the memory resource given on construction
+// and per-parse buffers from the one given to parse, which defaults to the
+// former.
+class cli {
+    struct subcommand {
+        std::pmr::string name;
+        std::function<void(cli&)> define;
+        // In subcommand_docs, which is in order of definition.
+        std::size_t doc_idx;
+    };
+
+    std::pmr::memory_resource* resource;
+    detail::option_table opts;
+    std::pmr::vector<detail::argument> args;
+    std::pmr::vector<subcommand> subcommands;
+    detail::environment_index env_index;
+    std::optional<std::pmr::string> env_prefix;
+    bool has_multi_argument = false;
+    std::optional<response_file_format> response_files;
+    // Set on the cli of a command named after a --, whose arguments are
+    // then all positional too.
+    bool are_options_terminated = false;
+    std::pmr::vector<detail::lazy_check> lazy_checks;
+    // Those of the command of the latest parse, whose cli is gone.
+    std::pmr::vector<detail::lazy_check> subcommand_lazy_checks;
+    // With string_view bindings, or subcommands that may have them, the
+    // config files loaded stay mapped while the cli lives, and the response
+    // files of the latest parse until the next parse, as the bound views
+    // may point into them. The files of a subcommand's cli count as
+    // response files of the parse that ran it.
+    bool has_view_bindings = false;
+    std::pmr::vector<detail::mapped_file> viewed_config_files;
+    std::pmr::vector<detail::mapped_file> viewed_response_files;
+    std::pmr::vector<detail::help_doc> option_docs;
+    std::pmr::vector<detail::help_doc> argument_docs;
+    std::pmr::vector<detail::help_doc> subcommand_docs;
+    // Rendered help for help_program at help_width; empty when stale.
+    std::pmr::string help_text;
+    std::pmr::string help_program;
+    std::size_t help_width = 0;
+
+   public:
+    // Returned by add_option, add_argument and add_subcommand to document
+    // what was just added in the generated help:
+    //     cli.add_option(port, "--port", "-p").describe("Port", "PORT");
+    class help_entry {
+        cli* parent;
+        std::pmr::vector<detail::help_doc>* docs;
+        std::size_t idx;
+
+       public:
+        help_entry(
+            cli& parent,
+            std::pmr::vector<detail::help_doc>& docs,
+            std::size_t idx)
+            : parent{&parent}, docs{&docs}, idx{idx}
+        {
+        }
+
+        // placeholder names the value of an option or the argument, as in
+        // "--port PORT"; it is ignored for flags and subcommands.
+        auto describe(
+            std::string_view description,
+            std::string_view placeholder = {}) -> help_entry&
+        {
+            (*docs)[idx].description = description;
+            (*docs)[idx].placeholder = placeholder;
+            parent->help_text.clear();
+            return *this;
+        }
+    };
+
+    cli() : cli(std::pmr::get_default_resource()) {}
+
+    explicit cli(std::pmr::memory_resource* resource)
+        : resource{resource}, opts{resource}, args{resource},
+          subcommands{resource}, env_index{resource}, lazy_checks{resource},
+          subcommand_lazy_checks{resource},
+          viewed_config_files{resource}, viewed_response_files{resource},
+          option_docs{resource}, argument_docs{resource},
+          subcommand_docs{resource},
+          help_text{resource}, help_program{resource}
+    {
+    }
+
+    // When env_var is given, the option is also read from that environment
+    // variable. Options given in argv take precedence.
+    auto add_option(
+        bool& var,
+        std::string_view name,
+        std::string_view shorthand,
+        std::string_view env_var = {}) -> help_entry
+    {
+        return add_option_impl(
+            detail::bound_flag{var},
+            name,
+            shorthand,
+            env_var);
+    }
+
+    auto add_option(
+        flag_bit bit,
+        std::string_view name,
+        std::string_view shorthand,
+        std::string_view env_var = {}) -> help_entry
+    {
+        return add_option_impl(bit.flag, name, shorthand, env_var);
+    }
+
+    template <bindable T>
+    auto add_option(
+        T& var,
+        std::string_view name,
+        std::string_view shorthand,
+        std::string_view env_var = {}) -> help_entry
+    {
+        auto entry = add_option_impl(
+            detail::bound_value{var},
+            name,
+            shorthand,
+            env_var);
+        track_binding(var);
+        return entry;
+    }
+
+    template <bindable T>
+        requires std::default_initializable<T>
+    auto add_option(
+        std::optional<T>& var,
+        std::string_view name,
+        std::string_view shorthand,
+        std::string_view env_var = {}) -> help_entry
+    {
+        auto entry = add_option_impl(
+            detail::bound_value{var},
+            name,
+            shorthand,
+            env_var);
+        track_binding(var);
+        return entry;
+    }
+
+    // Adds many options at once. Their names are validated by sorting them
+    // instead of looking each one up in a growing table, every duplicate is
+    // reported in a single error, and storage is reserved once. Nothing is
+    // added if any definition is invalid.
+    void add_options(std::span<option_definition const> definitions)
+    {
+        for (auto const& def : definitions) {
+            detail::validate_option_name(def.name);
+            detail::validate_option_shorthand(def.shorthand);
+        }
+
+        auto env_vars = environment_variables{resource};
+        for (auto i = std::size_t{0}; i < definitions.size(); ++i) {
+            auto const& def = definitions[i];
+            if (!def.env_var.empty()) {
+                detail::validate_environment_variable(def.env_var);
+                env_vars.emplace_back(def.env_var, opts.size() + i);
+            }
+            else if (env_prefix) {
+                env_vars.emplace_back(
+                    detail::environment_variable_name(
+                        *env_prefix,
+                        def.name,
+                        resource),
+                    opts.size() + i);
+            }
+        }
+        validate_environment_variables(env_vars);
+
+        auto new_opts = std::pmr::vector<detail::option>{resource};
+        new_opts.reserve(definitions.size());
+        for (auto const& def : definitions) {
+            new_opts.push_back(detail::option{
+                def.var,
+                std::pmr::string{def.name, resource},
+                std::pmr::string{def.shorthand, resource},
+                std::pmr::string{def.env_var, resource}});
+        }
+        if (auto const duplicates = opts.append(new_opts);
+            !duplicates.empty()) {
+            auto message = std::string{"Options are already defined:"};
+            for (auto const name : duplicates) {
+                message.append(" ").append(name);
+            }
+            throw invalid_cli_definition{message};
+        }
+        detail::reserve_more(option_docs, definitions.size());
+        for (auto const& def : definitions) {
+            option_docs.push_back(empty_doc());
+            option_docs.back().description = def.description;
+            option_docs.back().placeholder = def.placeholder;
+            add_lazy_check(def.lazy_check);
+            has_view_bindings = has_view_bindings || def.keeps_views;
+        }
+        add_environment_variables(env_vars);
+        help_text.clear();
+    }
+
+    void add_options(std::initializer_list<option_definition> definitions)
+    {
+        add_options(std::span{definitions.begin(), definitions.end()});
+    }
+
+    // Reads every option without its own environment variable from prefix
+    // followed by its name in upper case, with dashes replaced by
+    // underscores: "--log-level" is read from APP_LOG_LEVEL for "APP_".
+    void set_environment_prefix(std::string_view prefix)
+    {
+        if (env_prefix) {
+            throw invalid_cli_definition{
+                "The environment prefix is already set"};
+        }
+        auto new_prefix = std::pmr::string{prefix, resource};
+        auto env_vars = environment_variables{resource};
+        for (auto idx = std::size_t{0}; idx < opts.size(); ++idx) {
+            if (opts[idx].env_var.empty()) {
+                env_vars.emplace_back(
+                    detail::environment_variable_name(
+                        new_prefix,
+                        opts[idx].name,
+                        resource),
+                    idx);
+            }
+        }
+        validate_environment_variables(env_vars);
+        add_environment_variables(env_vars);
+        env_prefix = std::move(new_prefix);
+    }
+
+    template <bindable T>
+    auto add_argument(T& var) -> help_entry
+    {
+        auto entry = add_argument_impl(detail::bound_value{var});
+        track_binding(var);
+        return entry;
+    }
+
+    template <bindable T>
+        requires std::default_initializable<T>
+    auto add_argument(multi_t, std::vector<T>& var) -> help_entry
+    {
+        auto entry = add_multi_argument(detail::bound_container{var});
+        track_binding(var);
+        return entry;
+    }
+
+    template <bindable T>
+        requires std::default_initializable<T>
+    auto add_argument(parallel_multi_t, std::vector<T>& var) -> help_entry
+    {
+        auto entry = add_multi_argument(
+            detail::bound_container{detail::parallel_conversion_t{}, var});
+        track_binding(var);
+        return entry;
+    }
+
+    // Hands every value of the multi-argument to sink, a callback or an
+    // output iterator, as soon as it is converted, instead of collecting
+    // them. T has to be given explicitly:
+    //     cli.add_argument<int>(libcli::multi, callback);
+    template <bindable T, detail::value_sink<T> Sink>
+        requires std::default_initializable<T>
+    auto add_argument(multi_t, Sink& sink) -> help_entry
+    {
+        auto entry = add_multi_argument(
+            detail::bound_container{std::type_identity<T>{}, sink});
+        has_view_bindings = has_view_bindings || detail::keeps_views<T>;
+        return entry;
+    }
+
+    // Registers a git-style command. The first positional argument selects
+    // the command, and everything after it is parsed by a fresh cli that
+    // define fills in. define only runs for the command that is selected,
+    // so unused commands cost nothing beyond their name.
+    auto add_subcommand(
+        std::string_view name,
+        std::function<void(cli&)> define) -> help_entry
+    {
+        if (name.empty() || name.starts_with('-')) {
+            throw invalid_cli_definition{
+                detail::join(name, " is not a valid command name")};
+        }
+        if (!args.empty()) {
+            throw invalid_cli_definition{
+                "A cli with commands cannot have arguments"};
+        }
+        auto const it = find_subcommand(name, true);
+        if (it != subcommands.end() && it->name == name) {
+            throw invalid_cli_definition{
+                detail::join("Command ", name, " already exists")};
+        }
+        subcommands.insert(
+            it,
+            subcommand{
+                std::pmr::string{name, resource},
+                std::move(define),
+                subcommand_docs.size()});
+        subcommand_docs.push_back(empty_doc());
+        help_text.clear();
+        return {*this, subcommand_docs, subcommand_docs.size() - 1};
+    }
+
+    // Assigns the options listed in the config file at path. Keys are long
+    // option names without the leading dashes; keys in a [section] are
+    // prefixed with the section name and a dash, so "port" in [server]
+    // sets --server-port. Call it before parse: the environment and argv
+    // read by parse then override the file.
+    void load_config(std::string const& path)
+    {
+        auto file = detail::mapped_file{path};
+        auto const contents = file.contents();
+        auto name = std::pmr::string{"--", resource};
+        detail::read_config(
+            {contents.data(), contents.size()},
+            path,
+            [&](std::size_t line,
+                std::string_view section,
+                std::string_view key,
+                std::string_view value) {
+                name.resize(2);
+                if (!section.empty()) {
+                    name.append(section);
+                    name.push_back('-');
+                }
+                name.append(key);
+                auto const idx = opts.find(name);
+                if (!idx) {
+                    throw parsing_error{detail::join(
+                        path, ":", line, ": ", key, " is not an option")};
+                }
+                auto& opt = opts[*idx];
+                if (!opt.is_flag()) {
+                    if (auto const kind = opt.write_parsed(value)) {
+                        throw parsing_error{detail::join(
+                            path, ":", line, ": ",
+                            parse_error{*kind, value}.message())};
+                    }
+                }
+                else if (auto const flag = detail::parse_flag_value(value)) {
+                    opt.write(*flag);
+                }
+                else {
+                    throw parsing_error{detail::join(
+                        path, ":", line, ": ",
+                        key, "=", value, " is not a valid flag")};
+                }
+            });
+        if (keeps_input_views()) {
+            viewed_config_files.push_back(std::move(file));
+        }
+    }
+
+    // Returns a script that makes shell complete program's arguments by
+    // running "program __complete <words...>", which try_complete answers.
+    auto completion_script(completion_shell shell, std::string_view program)
+        const -> std::string
+    {
+        auto const function = detail::completion_function_name(program);
+        switch (shell) {
+            case completion_shell::bash:
+                return detail::join(
+                    function, "() {\n",
+                    "    local IFS=$'\\n'\n",
+                    "    COMPREPLY=($(", program,
+                    " __complete \"${COMP_WORDS[@]:1:COMP_CWORD}\"))\n",
+                    "}\n",
+                    "complete -o default -F ", function, " ", program, "\n");
+            case completion_shell::zsh:
+                return detail::join(
+                    "#compdef ", program, "\n",
+                    function, "() {\n",
+                    "    local -a completions\n",
+                    "    completions=(${(f)\"$(", program,
+                    " __complete \"${(@)words[2,CURRENT]}\")\"})\n",
+                    "    compadd -a completions || _files\n",
+                    "}\n",
+                    "compdef ", function, " ", program, "\n");
+            case completion_shell::fish:
+                return detail::join(
+                    "complete -c ", program, " -a '(", program,
+                    " __complete (commandline -opc)[2..-1]",
+                    " (commandline -ct))'\n");
+        }
+        return {};
+    }
+
+    // Answers the completion queries of the scripts made by
+    // completion_script. If argv is "program __complete <words...>", writes
+    // the candidates for the last word to out, one per line, and returns
+    // true; call it before the rest of the program starts up. Lookups are
+    // binary searches over the name indices, and only the command being
+    // completed is defined.
+    auto try_complete(int argc, char const* const* argv, std::ostream& out)
+        -> bool
+    {
+        if (argc < 2 || std::string_view{argv[1]} != "__complete") {
+            return false;
+        }
+        auto words = std::pmr::vector<std::string_view>(
+            argv + 2,
+            argv + argc,
+            resource);
+        if (words.empty()) { words.emplace_back(); }
+        complete(words, out);
+        return true;
+    }
+
+    // Usage and help text generated from the definition, wrapped to width
+    // columns or to the terminal. It is rendered into one buffer the first
+    // time it is asked for and reused until the definition changes.
+    auto help(std::string_view program, std::size_t width = 0)
+        -> std::string_view
+    {
+        if (width == 0) { width = detail::terminal_width(); }
+        if (help_text.empty() || help_program != program
+            || help_width != width) {
+            help_program = program;
+            help_width = width;
+            render_help();
+        }
+        return help_text;
+    }
+
+    // Writes help(program) to standard output with a single write.
+    void print_help(std::string_view program)
+    {
+        auto text = help(program);
+#if LIBCLI_HAS_MMAP
+        while (!text.empty()) {
+            auto const n = ::write(STDOUT_FILENO, text.data(), text.size());
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n <= 0) { return; }
+            text.remove_prefix(static_cast<std::size_t>(n));
+        }
+#else
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        std::fflush(stdout);
+#endif
+    }
+
+    // Makes parse replace every @path argument with the contents of the
+    // file at path. Response files are memory-mapped and split in place, so
+    // the arguments they hold are not copied.
+    void enable_response_files(
+        response_file_format format = response_file_format::whitespace)
+    {
+        response_files = format;
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+    void parse(
+        int argc,
+        char const* const* argv,
+        std::pmr::memory_resource* parse_resource = nullptr)
+    {
+        auto observer = parse_observer{};
+        parse(argc, argv, observer, parse_resource);
+    }
+
+    // Tells observer what the parse does; see parse_observer.
+    template <std::derived_from<parse_observer> Observer>
+    void parse(
+        int argc,
+        char const* const* argv,
+        Observer& observer,
+        std::pmr::memory_resource* parse_resource = nullptr)
+    {
+        if (argc <= 0) { throw std::logic_error{"Input cannot be empty"}; }
+        parse_resource = entry_resource(observer, parse_resource);
+        auto const views = std::pmr::vector<std::string_view>(
+            argv,
+            argv + argc,
+            parse_resource);
+        parse_input(std::span{views}, parse_resource, true, observer);
+    }
+
+    void parse(std::initializer_list<char const*> input)
+    {
+        parse(static_cast<int>(input.size()), data(input));
+    }
+
+    template <std::derived_from<parse_observer> Observer>
+    void parse(std::initializer_list<char const*> input, Observer& observer)
+    {
+        parse(static_cast<int>(input.size()), data(input), observer);
+    }
+
+    // Arguments are borrowed, not copied; they only have to outlive the call.
+    void parse(
+        std::span<std::string_view const> input,
+        std::pmr::memory_resource* parse_resource = nullptr)
+    {
+        auto observer = parse_observer{};
+        parse(input, observer, parse_resource);
+    }
+
+    template <std::derived_from<parse_observer> Observer>
+    void parse(
+        std::span<std::string_view const> input,
+        Observer& observer,
+        std::pmr::memory_resource* parse_resource = nullptr)
+    {
+        parse_input(
+            input,
+            entry_resource(observer, parse_resource),
+            true,
+            observer);
+    }
+
+    // Like parse, but a bad command line is reported by returning a
+    // parse_error instead of throwing, and without allocating. Errors in
+    // the cli definition, and exceptions thrown by the conversions of
+    // user-defined types, still propagate.
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+    auto try_parse(
+        int argc,
+        char const* const* argv,
+        std::pmr::memory_resource* parse_resource = nullptr)
+        -> parse_result<void>
+    {
+        auto observer = parse_observer{};
+        return try_parse(argc, argv, observer, parse_resource);
+    }
+
+    template <std::derived_from<parse_observer> Observer>
+    auto try_parse(
+        int argc,
+        char const* const* argv,
+        Observer& observer,
+        std::pmr::memory_resource* parse_resource = nullptr)
+        -> parse_result<void>
+    {
+        if (argc <= 0) { throw std::logic_error{"Input cannot be empty"}; }
+        parse_resource = entry_resource(observer, parse_resource);
+        auto const views = std::pmr::vector<std::string_view>(
+            argv,
+            argv + argc,
+            parse_resource);
+        if (auto const error = parse_input(
+                std::span{views},
+                parse_resource,
+                false,
+                observer)) {
+            return *error;
+        }
+        return {};
+    }
+
+    auto try_parse(std::initializer_list<char const*> input)
+        -> parse_result<void>
+    {
+        return try_parse(static_cast<int>(input.size()), data(input));
+    }
+
+    template <std::derived_from<parse_observer> Observer>
+    auto try_parse(
+        std::initializer_list<char const*> input,
+        Observer& observer) -> parse_result<void>
+    {
+        return try_parse(static_cast<int>(input.size()), data(input), observer);
+    }
+
+    auto try_parse(
+        std::span<std::string_view const> input,
+        std::pmr::memory_resource* parse_resource = nullptr)
+        -> parse_result<void>
+    {
+        auto observer = parse_observer{};
+        return try_parse(input, observer, parse_resource);
+    }
+
+    template <std::derived_from<parse_observer> Observer>
+    auto try_parse(
+        std::span<std::string_view const> input,
+        Observer& observer,
+        std::pmr::memory_resource* parse_resource = nullptr)
+        -> parse_result<void>
+    {
+        if (auto const error = parse_input(
+                input,
+                entry_resource(observer, parse_resource),
+                false,
+                observer)) {
+            return *error;
+        }
+        return {};
+    }
+
+    // Converts every libcli::lazy bound to this cli, or to the command run
+    // by the latest parse, now, and throws parsing_error for the first one
+    // that is not valid, for callers that want bad values reported right
+    // after parsing.
+    void validate_all() const
+    {
+        for (auto const* checks : {&lazy_checks, &subcommand_lazy_checks}) {
+            for (auto const& [var_ptr, check] : *checks) {
+                if (auto const error = check(var_ptr)) {
+                    throw parsing_error{error->message()};
+                }
+            }
+        }
+    }
+
+   private:
+    // The resource a parse allocates from: the one it was given or this
+    // cli's, wrapped by the observer once, where the parse starts.
+    // Subcommands are handed it as it is.
+    template <typename Observer>
+    auto entry_resource(
+        Observer& observer,
+        std::pmr::memory_resource* parse_resource)
+        -> std::pmr::memory_resource*
+    {
+        return observer.wrap_resource(
+            parse_resource != nullptr ? parse_resource : resource);
+    }
+
+    void add_lazy_check(detail::lazy_check check)
+    {
+        if (check.check != nullptr) { lazy_checks.push_back(check); }
+    }
+
+    auto keeps_input_views() const -> bool
+    {
+        return has_view_bindings || !subcommands.empty();
+    }
+
+    template <typename T>
+    void track_binding(T const& var)
+    {
+        add_lazy_check(detail::make_lazy_check(var));
+        has_view_bindings = has_view_bindings || detail::keeps_views<T>;
+    }
+
+    auto empty_doc() const -> detail::help_doc
+    {
+        return {std::pmr::string{resource}, std::pmr::string{resource}};
+    }
+
+    // Placeholder an argument is shown with in the usage line.
+    auto argument_placeholder(std::size_t idx) const -> std::string_view
+    {
+        auto const& placeholder = argument_docs[idx].placeholder;
+        if (!placeholder.empty()) { return placeholder; }
+        return args[idx].is_multi() ? "ARGS" : "ARG";
+    }
+
+    void render_help()
+    {
+        constexpr auto max_label_width = std::size_t{30};
+        auto& out = help_text;
+        out.clear();
+        out.reserve(
+            256 + 64 * (opts.size() + args.size() + subcommands.size()));
+
+        out.append("Usage: ").append(help_program);
+        if (opts.size() != 0) { out.append(" [options]"); }
+        for (auto i = std::size_t{0}; i < args.size(); ++i) {
+            out.append(" ").append(argument_placeholder(i));
+            if (args[i].is_multi()) { out.append("..."); }
+        }
+        if (!subcommands.empty()) { out.append(" <command> [<args>]"); }
+        out.push_back('\n');
+
+        // Labels are padded to the widest one, up to max_label_width;
+        // descriptions of longer labels start on the next line.
+        auto const option_label_width = [&](std::size_t i) {
+            auto const& opt = opts[i];
+            auto const placeholder = option_docs[i].placeholder.empty()
+                                         ? std::string_view{"VALUE"}
+                                         : option_docs[i].placeholder;
+            return 6 + opt.name.size()
+                   + (opt.is_flag() ? 0 : 1 + placeholder.size());
+        };
+        auto label_width = std::size_t{0};
+        for (auto i = std::size_t{0}; i < opts.size(); ++i) {
+            label_width = std::max(label_width, option_label_width(i));
+        }
+        for (auto i = std::size_t{0}; i < args.size(); ++i) {
+            label_width =
+                std::max(label_width, 2 + argument_placeholder(i).size());
+        }
+        for (auto const& cmd : subcommands) {
+            label_width = std::max(label_width, 2 + cmd.name.size());
+        }
+        label_width = std::min(label_width, max_label_width) + 2;
+        auto const entry = [&](std::size_t column, std::string_view text) {
+            if (!text.empty()) {
+                if (column > label_width - 2) {
+                    out.push_back('\n');
+                    column = 0;
+                }
+                out.append(label_width - column, ' ');
+                detail::append_wrapped(
+                    out,
+                    text,
+                    label_width,
+                    label_width,
+                    std::max(help_width, label_width + 20));
+            }
+            out.push_back('\n');
+        };
+
+        if (std::ranges::any_of(argument_docs, [](auto const& doc) {
+                return !doc.description.empty();
+            })) {
+            out.append("\nArguments:\n");
+            for (auto i = std::size_t{0}; i < args.size(); ++i) {
+                auto const placeholder = argument_placeholder(i);
+                out.append("  ").append(placeholder);
+                entry(2 + placeholder.size(), argument_docs[i].description);
+            }
+        }
+        if (opts.size() != 0) {
+            out.append("\nOptions:\n");
+            for (auto i = std::size_t{0}; i < opts.size(); ++i) {
+                auto const& opt = opts[i];
+                if (opt.shorthand.empty()) { out.append("      "); }
+                else {
+                    out.append("  ").append(opt.shorthand).append(", ");
+                }
+                out.append(opt.name);
+                if (!opt.is_flag()) {
+                    auto const& placeholder = option_docs[i].placeholder;
+                    out.append(" ").append(
+                        placeholder.empty() ? std::string_view{"VALUE"}
+                                            : std::string_view{placeholder});
+                }
+                entry(option_label_width(i), option_docs[i].description);
+            }
+        }
+        if (!subcommands.empty()) {
+            out.append("\nCommands:\n");
+            for (auto const& cmd : subcommands) {
+                out.append("  ").append(cmd.name);
+                entry(
+                    2 + cmd.name.size(),
+                    subcommand_docs[cmd.doc_idx].description);
+            }
+        }
+    }
+
+    auto add_argument_impl(detail::argument::bound_variable var) -> help_entry
+    {
+        if (!subcommands.empty()) {
+            throw invalid_cli_definition{
+                "A cli with commands cannot have arguments"};
+        }
+        args.emplace_back(var);
+        argument_docs.push_back(empty_doc());
+        help_text.clear();
+        return {*this, argument_docs, argument_docs.size() - 1};
+    }
+
+    auto add_multi_argument(detail::bound_container container) -> help_entry
     {
-        args.emplace_back(detail::bound_container{var});
         if (has_multi_argument) {
             throw invalid_cli_definition{
                 "There cannot be more than one multi-argument"};
         }
-        has_multi_argument = true;
+        auto entry = add_argument_impl(container);
+        has_multi_argument = true;
+        return entry;
+    }
+
+    auto add_option_impl(
+        detail::option::bound_variable var,
+        std::string_view name,
+        std::string_view shorthand,
+        std::string_view env_var) -> help_entry
+    {
+        validate_option_specification(name, shorthand, opts);
+        if (!env_var.empty()) {
+            detail::validate_environment_variable(env_var);
+            add_environment_variable(
+                std::pmr::string{env_var, resource},
+                opts.size());
+        }
+        else if (env_prefix) {
+            add_environment_variable(
+                detail::environment_variable_name(*env_prefix, name, resource),
+                opts.size());
+        }
+        opts.push_back(detail::option{
+            var,
+            std::pmr::string{name, resource},
+            std::pmr::string{shorthand, resource},
+            std::pmr::string{env_var, resource}});
+        option_docs.push_back(empty_doc());
+        help_text.clear();
+        return {*this, option_docs, option_docs.size() - 1};
+    }
+
+    // Names of environment variables with the index of their option.
+    using environment_variables =
+        std::pmr::vector<std::pair<std::pmr::string, std::size_t>>;
+
+    // Every name used twice, or already used, is reported in one error.
+    void validate_environment_variables(
+        environment_variables const& env_vars) const
+    {
+        auto names = std::pmr::vector<std::string_view>{resource};
+        names.reserve(env_vars.size());
+        for (auto const& [env_var, idx] : env_vars) {
+            names.push_back(env_var);
+        }
+        std::ranges::sort(names);
+        auto duplicates = std::string{};
+        for (auto i = std::size_t{0}; i < names.size(); ++i) {
+            auto const is_repeated =
+                i + 1 < names.size() && names[i + 1] == names[i];
+            auto const is_reported = i > 0 && names[i - 1] == names[i];
+            if (!is_reported
+                && (is_repeated || env_index.contains(names[i]))) {
+                duplicates.append(" ").append(names[i]);
+            }
+        }
+        if (!duplicates.empty()) {
+            throw invalid_cli_definition{detail::join(
+                "Environment variables are used by more than one option:",
+                duplicates)};
+        }
+    }
+
+    void add_environment_variables(environment_variables& env_vars)
+    {
+        auto const num_env_vars = env_index.size() + env_vars.size();
+        if (static_cast<float>(num_env_vars)
+            > env_index.max_load_factor()
+                  * static_cast<float>(env_index.bucket_count())) {
+            env_index.reserve(std::max(num_env_vars, 2 * env_index.size()));
+        }
+        for (auto& [env_var, idx] : env_vars) {
+            env_index.try_emplace(std::move(env_var), idx);
+        }
+    }
+
+    void add_environment_variable(std::pmr::string env_var, std::size_t idx)
+    {
+        auto const [it, is_inserted] =
+            env_index.try_emplace(std::move(env_var), idx);
+        if (!is_inserted) {
+            throw invalid_cli_definition{detail::join(
+                "Environment variable ",
+                it->first,
+                " is used by more than one option")};
+        }
+    }
+
+    // Expands response files, then reads the environment and argv. With
+    // is_throwing, an error is thrown as parsing_error while the response
+    // files its text may view are still mapped; otherwise it is returned,
+    // pointing at the argument in input it came from, and the files are
+    // kept for its text. parse_resource is the one from entry_resource.
+    template <typename Observer>
+    auto parse_input(
+        std::span<std::string_view const> input,
+        std::pmr::memory_resource* parse_resource,
+        bool is_throwing,
+        Observer& observer) -> std::optional<parse_error>
+    {
+        if (input.empty()) {
+            throw std::logic_error{"Input cannot be empty"};
+        }
+        viewed_response_files.clear();
+        subcommand_lazy_checks.clear();
+        auto expanded = std::pmr::vector<std::string_view>{parse_resource};
+        auto files = std::pmr::vector<detail::mapped_file>{parse_resource};
+        // Where the expansion of each argument starts within expanded.
+        auto starts = std::pmr::vector<std::size_t>{parse_resource};
+        auto strs = input.subspan(1);
+        auto error = std::optional<parse_error>{};
+        if (response_files
+            && std::ranges::any_of(strs, [](std::string_view s) {
+                   return s.starts_with('@');
+               })) {
+            auto expander = detail::response_file_expander{
+                *response_files,
+                expanded,
+                files};
+            auto const phase = detail::observed_phase{
+                observer,
+                parse_phase::response_files};
+            starts.reserve(strs.size());
+            for (auto i = std::size_t{0}; i < strs.size() && !error; ++i) {
+                starts.push_back(expanded.size());
+                if (auto const kind = expander.expand(strs[i])) {
+                    error = parse_error{*kind, strs[i], i + 1};
+                }
+            }
+            if (!error) { strs = expanded; }
+        }
+        if (!error) {
+            error =
+                parse_arguments(strs, parse_resource, is_throwing, observer);
+            if (error && !starts.empty()
+                && error->argv_index != parse_error::npos) {
+                auto const first = std::ranges::upper_bound(
+                    starts,
+                    error->argv_index - 1);
+                auto const idx =
+                    static_cast<std::size_t>(first - starts.begin());
+                error->argv_index = idx;
+            }
+        }
+        if (error && is_throwing) { throw parsing_error{error->message()}; }
+        if (error || keeps_input_views()) {
+            std::ranges::move(files, std::back_inserter(viewed_response_files));
+        }
+        return error;
+    }
+
+    template <typename Observer>
+    auto parse_arguments(
+        std::span<std::string_view const> strs,
+        std::pmr::memory_resource* parse_resource,
+        bool is_throwing,
+        Observer& observer) -> std::optional<parse_error>
+    {
+        if (!env_index.empty()) {
+            auto const phase =
+                detail::observed_phase{observer, parse_phase::environment};
+            if (auto error =
+                    read_environment(detail::environment(), observer)) {
+                return error;
+            }
+        }
+        auto const tokens = detail::program_arguments_token_view{
+            strs,
+            opts,
+            are_options_terminated};
+        auto error = std::optional<parse_error>{};
+        {
+            auto const phase =
+                detail::observed_phase{observer, parse_phase::arguments};
+            error = subcommands.empty()
+                        ? parse_tokens(tokens, parse_resource, observer)
+                        : dispatch_subcommand(
+                            tokens,
+                            strs,
+                            parse_resource,
+                            is_throwing,
+                            observer);
+        }
+        if (error) { detail::locate(strs, *error); }
+        return error;
+    }
+
+    // A single pass over the environment, looking every entry up in the
+    // index of declared names. Runs before argv is read so argv wins.
+    // Errors view the whole NAME=value entry.
+    template <typename Observer>
+    auto read_environment(char const* const* env, Observer& observer)
+        -> std::optional<parse_error>
+    {
+        for (; env != nullptr && *env != nullptr; ++env) {
+            auto const entry = std::string_view{*env};
+            auto const pos = entry.find('=');
+            if (pos == std::string_view::npos) { continue; }
+            auto const env_var = entry.substr(0, pos);
+            auto const found = env_index.find(env_var);
+            if (found == env_index.end()) { continue; }
+            auto& opt = opts[found->second];
+            auto const value = entry.substr(pos + 1);
+            if (!opt.is_flag()) {
+                auto const kind = opt.write_parsed(value);
+                observer.on_conversions(
+                    binding_kind::option,
+                    found->second,
+                    1,
+                    kind.has_value());
+                if (kind) {
+                    return parse_error{
+                        *kind,
+                        entry,
+                        parse_error::npos,
+                        found->second};
+                }
+            }
+            else if (auto const flag = detail::parse_flag_value(value)) {
+                opt.write(*flag);
+            }
+            else {
+                return parse_error{
+                    parse_errc::invalid_value,
+                    entry,
+                    parse_error::npos,
+                    found->second};
+            }
+        }
+        return std::nullopt;
+    }
+
+    template <typename Observer>
+    auto parse_tokens(
+        detail::program_arguments_token_view const& tokens,
+        std::pmr::memory_resource* parse_resource,
+        Observer& observer) -> std::optional<parse_error>
+    {
+        auto const multi_idx = detail::find_multi_argument(args);
+        auto const* collecting_container =
+            multi_idx == args.size()
+                ? nullptr
+                : std::get_if<detail::bound_container>(
+                    &args[multi_idx].bound_var);
+        auto collected = std::pmr::vector<std::string_view>{parse_resource};
+        if (collecting_container != nullptr) {
+            // The other arguments take a value each; the remaining strings
+            // bound how many values the multi-argument can get, so that it
+            // grows at most once.
+            auto const max_values =
+                tokens.max_values()
+                - std::min(tokens.max_values(), args.size() - 1);
+            if (collecting_container->wants_all_at_once()) {
+                collected.reserve(max_values);
+            }
+            else {
+                collecting_container->reserve(max_values);
+                collecting_container = nullptr;
+            }
+        }
+        auto positionals = detail::positional_binder{
+            args.size(),
+            multi_idx,
+            [&](std::size_t idx,
+                std::string_view value) -> std::optional<parse_error> {
+                if (idx == multi_idx && collecting_container != nullptr) {
+                    collected.push_back(value);
+                    return std::nullopt;
+                }
+                auto const kind = args[idx].write_parsed(value);
+                observer.on_conversions(
+                    binding_kind::argument,
+                    idx,
+                    1,
+                    kind.has_value());
+                if (kind) { return parse_error{*kind, value}; }
+                return std::nullopt;
+            },
+            parse_resource};
+        auto token_visitor = detail::overloaded{
+            [&](detail::positional_token const& tok) {
+                observer.on_token(token_kind::positional);
+                return positionals.push(tok.value);
+            },
+            [&](auto const& tok) { return write_option(tok, observer); }};
+        for (auto it = tokens.begin(); it != tokens.end(); ++it) {
+            if (write_cluster(it, observer)) { continue; }
+            if (auto error = std::visit(token_visitor, *it)) { return error; }
+        }
+        if (auto error = positionals.finish()) { return error; }
+        if (collecting_container != nullptr) {
+            auto const failure = [&] {
+                auto const phase = detail::observed_phase{
+                    observer,
+                    parse_phase::collected_arguments};
+                return collecting_container->push_back_all_parsed(collected);
+            }();
+            observer.on_conversions(
+                binding_kind::argument,
+                multi_idx,
+                failure ? failure->idx + 1 : collected.size(),
+                failure.has_value());
+            if (failure) {
+                return parse_error{failure->kind, collected[failure->idx]};
+            }
+        }
+        return std::nullopt;
+    }
+
+    // A cluster such as -abc whose letters all set bits of one word is
+    // written with a single mask, once every letter is known to be such a
+    // flag. For any other cluster, false is returned and its letters are
+    // left to their own tokens, errors included.
+    template <typename Iterator, typename Observer>
+    auto write_cluster(Iterator& it, Observer& observer) -> bool
+    {
+        auto const* head = std::get_if<detail::flag_token>(&*it);
+        if (head != nullptr && !head->cluster.empty()
+            && write_cluster(*head, observer)) [[unlikely]] {
+            it.skip_cluster();
+            return true;
+        }
+        return false;
+    }
+
+    template <typename Observer>
+    auto write_cluster(detail::flag_token const& head, Observer& observer)
+        -> bool
+    {
+        auto const* bits =
+            std::get_if<detail::bound_bits>(&opts[head.flag_idx].bound_var);
+        if (bits == nullptr) { return false; }
+        auto all = *bits;
+        for (auto const letter : head.cluster) {
+            auto const name = std::array{'-', letter};
+            auto const idx = opts.find({name.data(), name.size()});
+            if (!idx) { return false; }
+            auto const* other =
+                std::get_if<detail::bound_bits>(&opts[*idx].bound_var);
+            if (other == nullptr) { return false; }
+            auto const merged = all.merged(*other);
+            if (!merged) { return false; }
+            all = *merged;
+        }
+        all.assign(true);
+        for (auto i = std::size_t{0}; i <= head.cluster.size(); ++i) {
+            observer.on_token(token_kind::flag);
+        }
+        return true;
+    }
+
+    template <typename Observer>
+    auto write_option(detail::flag_token const& tok, Observer& observer)
+        -> std::optional<parse_error>
+    {
+        observer.on_token(token_kind::flag);
+        opts[tok.flag_idx].write(true);
+        return std::nullopt;
+    }
+
+    template <typename Observer>
+    auto write_option(detail::option_token const& tok, Observer& observer)
+        -> std::optional<parse_error>
+    {
+        observer.on_token(token_kind::option);
+        auto const kind = opts[tok.option_idx].write_parsed(tok.value);
+        observer.on_conversions(
+            binding_kind::option,
+            tok.option_idx,
+            1,
+            kind.has_value());
+        if (kind) {
+            return parse_error{
+                *kind,
+                tok.value,
+                parse_error::npos,
+                tok.option_idx};
+        }
+        return std::nullopt;
+    }
+
+    template <typename Observer>
+    static auto write_option(
+        detail::error_token const& tok,
+        Observer& observer) -> std::optional<parse_error>
+    {
+        if (tok.kind == parse_errc::not_an_option) {
+            observer.on_unknown_name(tok.text);
+        }
+        return tok.error();
+    }
+
+    void complete(std::span<std::string_view const> words, std::ostream& out)
+    {
+        auto const current = words.back();
+        auto are_options_terminated = false;
+        auto expects_value = false;
+        for (auto i = std::size_t{0}; i + 1 < words.size(); ++i) {
+            auto const word = words[i];
+            if (expects_value) { expects_value = false; }
+            else if (!are_options_terminated && word == "--") {
+                are_options_terminated = true;
+            }
+            else if (!are_options_terminated && word.starts_with('-')) {
+                auto const idx = opts.find(word);
+                expects_value = idx && !opts[*idx].is_flag();
+            }
+            else if (!subcommands.empty()) {
+                auto const cmd = find_subcommand(word);
+                if (cmd == subcommands.end()) { return; }
+                auto sub = cli{resource};
+                cmd->define(sub);
+                sub.complete(words.subspan(i + 1), out);
+                return;
+            }
+        }
+        if (expects_value) { return; }
+        if (!are_options_terminated && current.starts_with('-')) {
+            for (auto const idx : opts.with_prefix(current)) {
+                out << opts[idx].name << '\n';
+            }
+            return;
+        }
+        auto cmd = find_subcommand(current, true);
+        for (; cmd != subcommands.end() && cmd->name.starts_with(current);
+             ++cmd) {
+            out << cmd->name << '\n';
+        }
+    }
+
+    // The command called name, or with is_prefix the first command whose
+    // name is not less than it.
+    auto find_subcommand(std::string_view name, bool is_prefix = false)
+        -> std::pmr::vector<subcommand>::iterator
+    {
+        auto const it = std::ranges::lower_bound(
+            subcommands,
+            name,
+            {},
+            [](subcommand const& cmd) -> std::string_view { return cmd.name; });
+        if (is_prefix || it == subcommands.end() || it->name == name) {
+            return it;
+        }
+        return subcommands.end();
+    }
+
+    // Options before the command name belong to this cli; the command name
+    // and everything after it are handed to the command's own cli.
+    // Errors of the command are reported with argv indices of this cli;
+    // their option index is the one in the command.
+    template <typename Observer>
+    auto dispatch_subcommand(
+        detail::program_arguments_token_view const& tokens,
+        std::span<std::string_view const> strs,
+        std::pmr::memory_resource* parse_resource,
+        bool is_throwing,
+        Observer& observer) -> std::optional<parse_error>
+    {
+        for (auto it = tokens.begin(); it != tokens.end(); ++it) {
+            if (write_cluster(it, observer)) { continue; }
+            auto const* positional =
+                std::get_if<detail::positional_token>(&*it);
+            if (positional == nullptr) {
+                auto error = std::visit(
+                    detail::overloaded{
+                        [&](detail::positional_token const&) {
+                            return std::optional<parse_error>{};
+                        },
+                        [&](auto const& tok) {
+                            return write_option(tok, observer);
+                        }},
+                    *it);
+                if (error) { return error; }
+                continue;
+            }
+            observer.on_token(token_kind::positional);
+            auto const cmd = find_subcommand(positional->value);
+            if (cmd == subcommands.end()) {
+                observer.on_unknown_name(positional->value);
+                return parse_error{
+                    parse_errc::not_a_command,
+                    positional->value};
+            }
+            auto sub = cli{resource};
+            cmd->define(sub);
+            sub.are_options_terminated = it.options_terminated();
+            auto const offset = it.position();
+            auto error = std::optional<parse_error>{};
+            try {
+                error = sub.parse_input(
+                    strs.subspan(offset),
+                    parse_resource,
+                    is_throwing,
+                    observer);
+            }
+            catch (...) {
+                keep_state_of(sub);
+                throw;
+            }
+            keep_state_of(sub);
+            if (error && error->argv_index != parse_error::npos) {
+                error->argv_index += offset + 1;
+            }
+            return error;
+        }
+        return parse_error{parse_errc::missing_command, {}};
+    }
+
+    // sub is gone after the dispatch, so the files its bound views may
+    // point into, and the checks of its lazy values, are kept here instead.
+    void keep_state_of(cli& sub)
+    {
+        auto kept = std::back_inserter(viewed_response_files);
+        kept = std::ranges::move(sub.viewed_config_files, kept).out;
+        std::ranges::move(sub.viewed_response_files, kept);
+        auto checks = std::back_inserter(subcommand_lazy_checks);
+        checks = std::ranges::move(sub.lazy_checks, checks).out;
+        std::ranges::move(sub.subcommand_lazy_checks, checks);
+    }
+};
+
+namespace detail {
+
+template <std::size_t N>
+struct fixed_string {
+    std::array<char, N - 1> chars{};
+
+    // NOLINTNEXTLINE(hicpp-explicit-conversions, cppcoreguidelines-avoid-c-arrays)
+    consteval fixed_string(char const (&str)[N])
+    {
+        std::copy_n(std::begin(str), N - 1, chars.begin());
+    }
+
+    constexpr auto view() const -> std::string_view
+    {
+        return {chars.data(), chars.size()};
+    }
+};
+
+// clang-format off
+template <typename T>
+concept static_bindable =
+    std::same_as<T, bool> || bindable<T>
+    || requires { typename T::value_type; }
+       && std::same_as<T, std::optional<typename T::value_type>>
+       && bindable<typename T::value_type>
+       && std::default_initializable<typename T::value_type>;
+// clang-format on
+
+struct option_spec {
+    std::string_view name;
+    std::string_view shorthand;
+    bool flag;
+
+    constexpr auto is_flag() const -> bool { return flag; }
+};
+
+constexpr auto is_ascii_alpha(char c) -> bool
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+constexpr auto is_ascii_alnum(char c) -> bool
+{
+    return is_ascii_alpha(c) || (c >= '0' && c <= '9');
+}
+
+constexpr auto is_valid_option_name(std::string_view name) -> bool
+{
+    return name.size() >= 3 && name.starts_with("--")
+           && std::ranges::all_of(name.substr(2), [](char c) {
+                  return is_ascii_alnum(c) || c == '-';
+              });
+}
+
+constexpr auto is_valid_option_shorthand(std::string_view shorthand) -> bool
+{
+    return shorthand.size() == 2 && shorthand[0] == '-'
+           && is_ascii_alpha(shorthand[1]);
+}
+
+// Compile-time counterpart of option_table, built once into read-only data.
+template <std::size_t N>
+class static_option_table {
+    static constexpr auto npos = std::numeric_limits<std::size_t>::max();
+
+    std::array<option_spec, N> specs;
+    std::array<std::size_t, N> by_name{};
+    std::array<std::size_t, 128> by_shorthand{};
+
+   public:
+    constexpr explicit static_option_table(std::array<option_spec, N> specs)
+        : specs{specs}
+    {
+        by_shorthand.fill(npos);
+        for (auto i = std::size_t{0}; i < N; ++i) {
+            by_name[i] = i;
+            if (auto const c = shorthand_char(specs[i].shorthand)) {
+                by_shorthand[*c] = i;
+            }
+        }
+        std::ranges::sort(by_name, {}, [&](std::size_t i) {
+            return this->specs[i].name;
+        });
+    }
+
+    constexpr auto find(std::string_view str) const
+        -> std::optional<std::size_t>
+    {
+        if (auto const c = shorthand_char(str)) {
+            auto const idx = by_shorthand[*c];
+            if (idx == npos) { return std::nullopt; }
+            return idx;
+        }
+        auto const it = std::ranges::lower_bound(
+            by_name,
+            str,
+            {},
+            [&](std::size_t i) { return specs[i].name; });
+        if (it == by_name.end() || specs[*it].name != str) {
+            return std::nullopt;
+        }
+        return *it;
+    }
+
+    constexpr auto operator[](std::size_t idx) const -> option_spec const&
+    {
+        return specs[idx];
+    }
+
+    constexpr auto has_valid_names() const -> bool
+    {
+        return std::ranges::all_of(specs, [](auto const& s) {
+            return is_valid_option_name(s.name);
+        });
+    }
+
+    constexpr auto has_valid_shorthands() const -> bool
+    {
+        return std::ranges::all_of(specs, [](auto const& s) {
+            return is_valid_option_shorthand(s.shorthand);
+        });
+    }
+
+    constexpr auto has_unique_names() const -> bool
+    {
+        for (auto i = std::size_t{1}; i < N; ++i) {
+            if (specs[by_name[i - 1]].name == specs[by_name[i]].name) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr auto has_unique_shorthands() const -> bool
+    {
+        for (auto i = std::size_t{0}; i < N; ++i) {
+            if (by_shorthand[*shorthand_char(specs[i].shorthand)] != i) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+template <typename T>
+inline auto assign_static(T& var, std::string_view input)
+    -> std::optional<parse_errc>
+{
+    if constexpr (requires { var.emplace(); }) {
+        var.emplace();
+        return from_string(input, *var);
+    }
+    else {
+        return from_string(input, var);
+    }
+}
+
+}  // namespace detail
+
+template <detail::fixed_string Name, detail::fixed_string Shorthand, typename T>
+    requires detail::static_bindable<T>
+struct static_option {
+    using value_type = T;
+    static constexpr auto name = Name.view();
+    static constexpr auto shorthand = Shorthand.view();
+};
+
+template <typename T>
+    requires detail::static_bindable<T> && (!std::same_as<T, bool>)
+struct static_argument {
+    using value_type = T;
+};
+
+// Alternative to cli for schemas known at compile time. Option names are
+// validated by the compiler, the lookup table is a constant, and each token
+// is dispatched to its variable by a generated comparison chain. Arguments
+// are assigned in the order they appear among Specs; multi-arguments are
+// not supported.
+//
+//     auto cli = libcli::static_cli<
+//         libcli::static_option<"--flag", "-f", bool>,
+//         libcli::static_argument<std::string>>{flag, path};
+template <typename... Specs>
+class static_cli {
+    template <typename Spec>
+    static constexpr auto is_option = requires { Spec::name; };
+
+    static constexpr auto spec_count = sizeof...(Specs);
+    static constexpr auto option_count =
+        (std::size_t{0} + ... + (is_option<Specs> ? 1 : 0));
+    static constexpr auto argument_count = spec_count - option_count;
+
+    // Positions within Specs of the options and of the arguments.
+    static constexpr auto positions = [] {
+        auto options = std::array<std::size_t, option_count>{};
+        auto arguments = std::array<std::size_t, argument_count>{};
+        auto o = std::size_t{0};
+        auto a = std::size_t{0};
+        auto i = std::size_t{0};
+        ((is_option<Specs> ? options[o++] = i++ : arguments[a++] = i++), ...);
+        return std::pair{options, arguments};
+    }();
+
+    static constexpr auto table = [] {
+        auto specs = std::array<detail::option_spec, option_count>{};
+        auto o = std::size_t{0};
+        auto const add = [&]<typename Spec>() {
+            if constexpr (is_option<Spec>) {
+                specs[o++] = detail::option_spec{
+                    Spec::name,
+                    Spec::shorthand,
+                    std::same_as<typename Spec::value_type, bool>};
+            }
+        };
+        (add.template operator()<Specs>(), ...);
+        return detail::static_option_table<option_count>{specs};
+    }();
+
+    static_assert(
+        table.has_valid_names(),
+        "Option name has to start with -- and at least one character and "
+        "has to be composed with alphanumeric characters or dashes");
+    static_assert(
+        table.has_valid_shorthands(),
+        "Option shorthand has to start with - and one alphabetic character");
+    static_assert(table.has_unique_names(), "Option name is already defined");
+    static_assert(
+        table.has_unique_shorthands(),
+        "Option shorthand is already defined");
+
+    std::tuple<typename Specs::value_type&...> vars;
+
+   public:
+    explicit static_cli(typename Specs::value_type&... vars) : vars{vars...}
+    {
     }
 
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
     void parse(int argc, char const* const* argv)
     {
-        using namespace std::ranges;
         if (argc <= 0) { throw std::logic_error{"Input cannot be empty"}; }
-        auto const args =
-            subrange{argv + 1, argv + argc}
-            | views::transform([](auto x) { return std::string{x}; });
-        auto const tokens = detail::program_arguments_token_view{
-            std::vector(args.begin(), args.end()),
-            opts};
-        auto const unmatched = parse_options(tokens);
-        parse_positional_arguments(unmatched);
+        auto const views = std::vector<std::string_view>(argv, argv + argc);
+        parse(std::span{views});
     }
 
     void parse(std::initializer_list<char const*> input)
@@ -569,64 +3816,445 @@ class cli {
         parse(static_cast<int>(input.size()), data(input));
     }
 
+    void parse(std::span<std::string_view const> input)
+    {
+        if (input.empty()) {
+            throw std::logic_error{"Input cannot be empty"};
+        }
+        auto num_positionals = std::size_t{0};
+        auto const check = [](std::optional<parse_errc> kind,
+                              std::string_view value) {
+            if (kind) {
+                throw parsing_error{parse_error{*kind, value}.message()};
+            }
+        };
+        auto token_visitor = detail::overloaded{
+            [&](detail::positional_token const& tok) {
+                if (num_positionals < argument_count) {
+                    check(
+                        dispatch_argument(
+                            num_positionals,
+                            tok.value,
+                            std::make_index_sequence<argument_count>{}),
+                        tok.value);
+                }
+                ++num_positionals;
+            },
+            [&](detail::flag_token const& tok) {
+                dispatch_option(
+                    tok.flag_idx,
+                    {},
+                    std::make_index_sequence<option_count>{});
+            },
+            [&](detail::option_token const& tok) {
+                check(
+                    dispatch_option(
+                        tok.option_idx,
+                        tok.value,
+                        std::make_index_sequence<option_count>{}),
+                    tok.value);
+            },
+            [](detail::error_token const& tok) {
+                throw parsing_error{tok.error().message()};
+            }};
+        auto const tokens =
+            detail::basic_token_view{input.subspan(1), table};
+        for (auto const& tok : tokens) { std::visit(token_visitor, tok); }
+        if (num_positionals < argument_count) {
+            throw parsing_error{"Wrong number of arguments"};
+        }
+    }
+
    private:
-    void add_option_impl(
-        detail::option::bound_variable var,
-        std::string name,
-        std::string shorthand)
+    template <std::size_t... Is>
+    auto dispatch_option(
+        std::size_t idx,
+        std::string_view value,
+        std::index_sequence<Is...>) -> std::optional<parse_errc>
+    {
+        auto kind = std::optional<parse_errc>{};
+        (void)((idx == Is && (kind = assign<positions.first[Is]>(value), true))
+               || ...);
+        return kind;
+    }
+
+    template <std::size_t... Is>
+    auto dispatch_argument(
+        std::size_t idx,
+        std::string_view value,
+        std::index_sequence<Is...>) -> std::optional<parse_errc>
+    {
+        auto kind = std::optional<parse_errc>{};
+        (void)((idx == Is
+                && (kind = assign<positions.second[Is]>(value), true))
+               || ...);
+        return kind;
+    }
+
+    template <std::size_t I>
+    auto assign(std::string_view value) -> std::optional<parse_errc>
+    {
+        auto& var = std::get<I>(vars);
+        if constexpr (std::is_same_v<decltype(var), bool&>) {
+            var = true;
+            return std::nullopt;
+        }
+        else {
+            return detail::assign_static(var, value);
+        }
+    }
+};
+
+namespace detail {
+
+template <auto Member>
+struct member_traits;
+
+template <typename Result, typename T, T Result::*Member>
+struct member_traits<Member> {
+    using result_type = Result;
+    using value_type = T;
+};
+
+// clang-format off
+template <typename T>
+concept multi_bindable =
+    requires { typename T::value_type; }
+    && std::same_as<T, std::vector<typename T::value_type>>
+    && bindable<typename T::value_type>
+    && std::default_initializable<typename T::value_type>;
+// clang-format on
+
+template <auto Member>
+inline auto assign_member(
+    typename member_traits<Member>::result_type& result,
+    std::string_view input) -> std::optional<parse_errc>
+{
+    if constexpr (std::same_as<
+                      typename member_traits<Member>::value_type,
+                      bool>) {
+        result.*Member = true;
+        return std::nullopt;
+    }
+    else {
+        return assign_static(result.*Member, input);
+    }
+}
+
+template <auto Member>
+inline auto push_back_member(
+    typename member_traits<Member>::result_type& result,
+    std::string_view input) -> std::optional<parse_errc>
+{
+    return from_string(input, (result.*Member).emplace_back());
+}
+
+template <typename Result>
+struct member_option {
+    auto (*assign)(Result& result, std::string_view input)
+        -> std::optional<parse_errc>;
+    bool flag;
+    std::pmr::string name;
+    std::pmr::string shorthand;
+
+    auto is_flag() const -> bool { return flag; }
+};
+
+template <typename Result>
+struct member_argument {
+    auto (*assign)(Result& result, std::string_view input)
+        -> std::optional<parse_errc>;
+    bool multi;
+
+    auto is_multi() const -> bool { return multi; }
+};
+
+}  // namespace detail
+
+// A single command line: a range of things viewable as strings, the
+// program name included.
+template <typename T>
+concept command_line =
+    std::ranges::input_range<T>
+    && std::convertible_to<std::ranges::range_reference_t<T>, std::string_view>;
+
+// Outcome of parsing one command line of a batch.
+template <typename Result>
+using batch_result = std::variant<Result, parsing_error>;
+
+// Command line definition that binds to data members of Result rather than
+// to variables, so it can be built once and then used for any number of
+// parses. parse is const and only touches the Result it returns, which
+// makes one parser safe to share between threads. The resource it is built
+// with only holds the definition: a parse allocates from the resource
+// passed to it, or from the default resource, so that resource is the one
+// that has to be thread-safe when parses run concurrently.
+//
+//     auto p = libcli::parser<options>{};
+//     p.add_option<&options::verbose>("--verbose", "-v");
+//     p.add_argument<&options::files>(libcli::multi);
+//     auto const opts = p.parse(argc, argv);
+template <std::default_initializable Result>
+class parser {
+    template <auto Member>
+    static constexpr auto is_member_of_result = std::same_as<
+        typename detail::member_traits<Member>::result_type,
+        Result>;
+
+    template <auto Member>
+    using value_type_of = typename detail::member_traits<Member>::value_type;
+
+    std::pmr::memory_resource* resource;
+    detail::basic_option_table<detail::member_option<Result>> opts;
+    std::pmr::vector<detail::member_argument<Result>> args;
+
+   public:
+    parser() : parser(std::pmr::get_default_resource()) {}
+
+    explicit parser(std::pmr::memory_resource* resource)
+        : resource{resource}, opts{resource}, args{resource}
+    {
+    }
+
+    template <auto Member>
+        requires is_member_of_result<Member>
+                 && detail::static_bindable<value_type_of<Member>>
+    void add_option(std::string_view name, std::string_view shorthand)
     {
         validate_option_specification(name, shorthand, opts);
-        opts.emplace_back(
-            std::move(var),
-            std::move(name),
-            std::move(shorthand));
+        opts.push_back(detail::member_option<Result>{
+            &detail::assign_member<Member>,
+            std::same_as<value_type_of<Member>, bool>,
+            std::pmr::string{name, resource},
+            std::pmr::string{shorthand, resource}});
+    }
+
+    template <auto Member>
+        requires is_member_of_result<Member>
+                 && detail::static_bindable<value_type_of<Member>>
+                 && (!std::same_as<value_type_of<Member>, bool>)
+    void add_argument()
+    {
+        args.push_back({&detail::assign_member<Member>, false});
+    }
+
+    template <auto Member>
+        requires is_member_of_result<Member>
+                 && detail::multi_bindable<value_type_of<Member>>
+    void add_argument(multi_t)
+    {
+        if (detail::find_multi_argument(args) != args.size()) {
+            throw invalid_cli_definition{
+                "There cannot be more than one multi-argument"};
+        }
+        args.push_back({&detail::push_back_member<Member>, true});
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+    auto parse(
+        int argc,
+        char const* const* argv,
+        std::pmr::memory_resource* parse_resource = nullptr) const -> Result
+    {
+        if (argc <= 0) { throw std::logic_error{"Input cannot be empty"}; }
+        if (parse_resource == nullptr) {
+            parse_resource = std::pmr::get_default_resource();
+        }
+        auto const views = std::pmr::vector<std::string_view>(
+            argv,
+            argv + argc,
+            parse_resource);
+        return parse(std::span{views}, parse_resource);
+    }
+
+    auto parse(std::initializer_list<char const*> input) const -> Result
+    {
+        return parse(static_cast<int>(input.size()), data(input));
+    }
+
+    auto parse(
+        std::span<std::string_view const> input,
+        std::pmr::memory_resource* parse_resource = nullptr) const -> Result
+    {
+        return try_parse(input, parse_resource).value();
+    }
+
+    // Like parse, but a bad command line is reported by returning a
+    // parse_error instead of throwing, and without allocating.
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+    auto try_parse(
+        int argc,
+        char const* const* argv,
+        std::pmr::memory_resource* parse_resource = nullptr) const
+        -> parse_result<Result>
+    {
+        if (argc <= 0) { throw std::logic_error{"Input cannot be empty"}; }
+        if (parse_resource == nullptr) {
+            parse_resource = std::pmr::get_default_resource();
+        }
+        auto const views = std::pmr::vector<std::string_view>(
+            argv,
+            argv + argc,
+            parse_resource);
+        return try_parse(std::span{views}, parse_resource);
+    }
+
+    auto try_parse(std::initializer_list<char const*> input) const
+        -> parse_result<Result>
+    {
+        return try_parse(static_cast<int>(input.size()), data(input));
     }
 
-    auto parse_options(const detail::program_arguments_token_view& tokens)
-        -> std::vector<detail::positional_token>
+    auto try_parse(
+        std::span<std::string_view const> input,
+        std::pmr::memory_resource* parse_resource = nullptr) const
+        -> parse_result<Result>
     {
-        auto unmatched = std::vector<detail::positional_token>{};
+        if (input.empty()) {
+            throw std::logic_error{"Input cannot be empty"};
+        }
+        if (parse_resource == nullptr) {
+            parse_resource = std::pmr::get_default_resource();
+        }
+        auto result = Result{};
+        auto positionals = detail::positional_binder{
+            args.size(),
+            detail::find_multi_argument(args),
+            [&](std::size_t idx,
+                std::string_view value) -> std::optional<parse_error> {
+                if (auto const kind = args[idx].assign(result, value)) {
+                    return parse_error{*kind, value};
+                }
+                return std::nullopt;
+            },
+            parse_resource};
         auto token_visitor = detail::overloaded{
             [&](detail::positional_token const& tok) {
-                unmatched.push_back(tok);
+                return positionals.push(tok.value);
             },
             [&](detail::flag_token const& tok) {
-                opts[tok.flag_idx].write(true);
+                (void)opts[tok.flag_idx].assign(result, {});
+                return std::optional<parse_error>{};
             },
             [&](detail::option_token const& tok) {
-                opts[tok.option_idx].write_parsed(tok.value);
+                auto error = std::optional<parse_error>{};
+                if (auto const kind =
+                        opts[tok.option_idx].assign(result, tok.value)) {
+                    error = parse_error{
+                        *kind,
+                        tok.value,
+                        parse_error::npos,
+                        tok.option_idx};
+                }
+                return error;
+            },
+            [](detail::error_token const& tok) {
+                return std::optional<parse_error>{tok.error()};
             }};
-        for (const auto tok : tokens) { std::visit(token_visitor, tok); }
-        return unmatched;
+        auto const strs = input.subspan(1);
+        auto error = std::optional<parse_error>{};
+        for (auto const& tok : detail::basic_token_view{strs, opts}) {
+            error = std::visit(token_visitor, tok);
+            if (error) { break; }
+        }
+        if (!error) { error = positionals.finish(); }
+        if (!error) { return result; }
+        detail::locate(strs, *error);
+        return *error;
     }
 
-    void parse_positional_arguments(
-        std::vector<detail::positional_token> const& tokens)
+    // Parses every command line of lines on num_threads threads, all
+    // hardware threads by default, and returns the outcomes in the order
+    // of lines. Each thread takes chunks of lines off a shared counter and
+    // allocates its per-parse buffers from its own pool, which gets memory
+    // from new and delete as the parser's resource need not be
+    // thread-safe. An empty line is reported as its parsing_error; other
+    // errors stop the batch and are rethrown.
+    template <std::ranges::random_access_range Lines>
+        requires command_line<std::ranges::range_reference_t<Lines const>>
+    auto parse_batch(Lines const& lines, std::size_t num_threads = 0) const
+        -> std::vector<batch_result<Result>>
     {
-        auto token_it = tokens.begin();
-        auto arg_it = args.begin();
-        auto bound_variable_visitor = detail::overloaded{
-            [&](detail::bound_value& value) {
-                value.assign_parsed(token_it->value);
-                ++token_it;
-            },
-            [&](detail::bound_container& container) {
-                auto const num_args_left = args.end() - (arg_it + 1);
-                auto const limit = tokens.end() - num_args_left;
-                if (token_it > limit) {
-                    throw parsing_error{"Wrong number of arguments"};
-                }
-                while (token_it < limit) {
-                    container.push_back_parsed(token_it->value);
-                    ++token_it;
+        constexpr auto chunk_size = std::size_t{64};
+        auto const num_lines =
+            static_cast<std::size_t>(std::ranges::size(lines));
+        auto results = std::vector<batch_result<Result>>(num_lines);
+        if (num_threads == 0) {
+            num_threads = std::max(1U, std::thread::hardware_concurrency());
+        }
+        num_threads =
+            std::min(num_threads, (num_lines + chunk_size - 1) / chunk_size);
+
+        auto next_line = std::atomic<std::size_t>{0};
+        auto failure = std::exception_ptr{};
+        auto failure_mutex = std::mutex{};
+        auto const worker = [&] {
+            auto pool = std::pmr::unsynchronized_pool_resource{
+                std::pmr::new_delete_resource()};
+            auto views = std::pmr::vector<std::string_view>{&pool};
+            try {
+                while (true) {
+                    auto const begin = next_line.fetch_add(chunk_size);
+                    if (begin >= num_lines) { return; }
+                    auto const end = std::min(begin + chunk_size, num_lines);
+                    for (auto i = begin; i < end; ++i) {
+                        results[i] = parse_line(
+                            std::ranges::begin(lines)[static_cast<
+                                std::ranges::range_difference_t<Lines>>(i)],
+                            views,
+                            &pool);
+                    }
                 }
-            }};
-        while (arg_it < args.end()) {
-            if (token_it == tokens.end()) {
-                throw parsing_error{"Wrong number of arguments"};
             }
-            std::visit(bound_variable_visitor, arg_it->bound_var);
-            ++arg_it;
+            catch (...) {
+                next_line = num_lines;
+                auto const lock = std::scoped_lock{failure_mutex};
+                if (!failure) { failure = std::current_exception(); }
+            }
+        };
+        {
+            auto threads = std::vector<std::jthread>{};
+            for (auto t = std::size_t{1}; t < num_threads; ++t) {
+                threads.emplace_back(worker);
+            }
+            worker();
+        }
+        if (failure) { std::rethrow_exception(failure); }
+        return results;
+    }
+
+   private:
+    template <command_line Line>
+    auto parse_line(
+        Line const& line,
+        std::pmr::vector<std::string_view>& views,
+        std::pmr::memory_resource* parse_resource) const -> batch_result<Result>
+    {
+        auto const to_batch_result = [](parse_result<Result>&& outcome) {
+            if (!outcome) {
+                return batch_result<Result>{
+                    parsing_error{outcome.error().message()}};
+            }
+            return batch_result<Result>{*std::move(outcome)};
+        };
+        auto const parse_views = [&](std::span<std::string_view const> input) {
+            if (input.empty()) {
+                return batch_result<Result>{
+                    parsing_error{"Input cannot be empty"}};
+            }
+            return to_batch_result(try_parse(input, parse_resource));
+        };
+        if constexpr (
+            std::ranges::contiguous_range<Line>
+            && std::same_as<
+                std::ranges::range_value_t<Line>,
+                std::string_view>) {
+            return parse_views(std::span{line});
+        }
+        else {
+            views.clear();
+            for (auto const& arg : line) { views.emplace_back(arg); }
+            return parse_views(views);
         }
     }
 };
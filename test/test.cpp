@@ -1,9 +1,18 @@
 #include <catch2/catch_test_macros.hpp>
+#include <bitset>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <libcli.hpp>
+#include <limits>
+#include <sstream>
+#include <thread>
 
 // TODO: https://www.gnu.org/software/libc/manual/html_node/Argument-Syntax.html
 
 using namespace std::string_literals;
+using namespace std::string_view_literals;
 
 TEST_CASE("empty argument list")
 {
@@ -128,6 +137,78 @@ TEST_CASE("parse option")
     }
 }
 
+TEST_CASE("parse arithmetic values")
+{
+    auto integer = 0;
+    auto unsigned_integer = std::optional<unsigned short>{};
+    auto floating = 0.0;
+    auto ids = std::vector<long long>{};
+
+    auto cli = libcli::cli{};
+    cli.add_option(integer, "--integer", "-i");
+    cli.add_option(unsigned_integer, "--unsigned", "-u");
+    cli.add_option(floating, "--floating", "-f");
+    cli.add_argument(libcli::multi, ids);
+
+    SECTION("valid")
+    {
+        cli.parse(
+            {"app_name",
+             "-i-42",
+             "--unsigned=+65535",
+             "--floating",
+             "2.5e3",
+             "1",
+             "--",
+             "-9223372036854775808"});
+        REQUIRE(integer == -42);
+        REQUIRE(unsigned_integer == 65535);
+        REQUIRE(floating == 2500.0);
+        auto const expected_ids =
+            std::vector{1LL, std::numeric_limits<long long>::min()};
+        REQUIRE(ids == expected_ids);
+    }
+
+    SECTION("trailing garbage")
+    {
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "--integer=12a", "1"}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "--floating=1.5.", "1"}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "1", " 2"}),
+            libcli::parsing_error);
+    }
+
+    SECTION("out of range")
+    {
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "--unsigned=65536", "1"}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "--unsigned=-1", "1"}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "9223372036854775808"}),
+            libcli::parsing_error);
+    }
+
+    SECTION("empty and sign only")
+    {
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "--integer=", "1"}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "--integer=+", "1"}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "--integer=+-1", "1"}),
+            libcli::parsing_error);
+    }
+}
+
 struct S {
     std::string str;
 };
@@ -191,6 +272,109 @@ TEST_CASE("multi-argument")
     // TODO
 }
 
+TEST_CASE("multi-argument sink")
+{
+    auto first = ""s;
+    auto penultimate = ""s;
+    auto last = 0;
+    auto cli = libcli::cli{};
+
+    SECTION("callback")
+    {
+        auto sum = 0;
+        auto count = 0;
+        auto sink = [&](int x) {
+            sum += x;
+            ++count;
+        };
+        cli.add_argument(first);
+        cli.add_argument<int>(libcli::multi, sink);
+        cli.add_argument(penultimate);
+        cli.add_argument(last);
+        cli.parse({"app_name", "a", "1", "2", "3", "b", "4"});
+        REQUIRE(first == "a");
+        REQUIRE(sum == 6);
+        REQUIRE(count == 3);
+        REQUIRE(penultimate == "b");
+        REQUIRE(last == 4);
+    }
+
+    SECTION("output iterator")
+    {
+        auto values = std::vector<double>{};
+        auto sink = std::back_inserter(values);
+        cli.add_argument<double>(libcli::multi, sink);
+        cli.add_argument(last);
+        cli.parse({"app_name", "0.5", "1.5", "2"});
+        REQUIRE(values == std::vector{0.5, 1.5});
+        REQUIRE(last == 2);
+    }
+
+    SECTION("empty")
+    {
+        auto sink = [](std::string const&) { FAIL_CHECK(); };
+        cli.add_argument<std::string>(libcli::multi, sink);
+        cli.add_argument(last);
+        cli.parse({"app_name", "2"});
+        REQUIRE(last == 2);
+        REQUIRE_THROWS_AS(cli.parse({"app_name"}), libcli::parsing_error);
+    }
+
+    SECTION("invalid value")
+    {
+        auto sink = [](int) {};
+        cli.add_argument<int>(libcli::multi, sink);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "1", "x"}),
+            libcli::parsing_error);
+    }
+}
+
+TEST_CASE("parallel multi-argument")
+{
+    auto storage = std::vector<std::string>{"app_name", "first"};
+    for (auto i = 0; i < 50'000; ++i) { storage.push_back(std::to_string(i)); }
+    storage.emplace_back("last");
+
+    auto first = ""s;
+    auto values = std::vector<int>{};
+    auto last = ""s;
+    auto cli = libcli::cli{};
+    cli.add_argument(first);
+    cli.add_argument(libcli::parallel_multi, values);
+    cli.add_argument(last);
+
+    SECTION("valid")
+    {
+        auto const views =
+            std::vector<std::string_view>(storage.begin(), storage.end());
+        cli.parse(views);
+        REQUIRE(first == "first");
+        REQUIRE(last == "last");
+        REQUIRE(values.size() == 50'000);
+        REQUIRE(values[12'345] == 12'345);
+        REQUIRE(values.back() == 49'999);
+    }
+
+    SECTION("first bad value is reported")
+    {
+        storage[2 + 30'000] = "bad30000";
+        storage[2 + 40'000] = "bad40000";
+        storage[2 + 20'000] = "bad20000";
+        auto const views =
+            std::vector<std::string_view>(storage.begin(), storage.end());
+        auto message = ""s;
+        try {
+            cli.parse(views);
+        }
+        catch (libcli::parsing_error const& ex) {
+            message = ex.what();
+        }
+        REQUIRE(message == "bad20000 is not a valid value");
+        REQUIRE(values.size() == 20'000);
+    }
+}
+
 TEST_CASE("connected flags")
 {
     auto a = false;
@@ -207,6 +391,44 @@ TEST_CASE("connected flags")
     // TODO add case where one of the joined options is not a flag
 }
 
+TEST_CASE("connected flags beyond the second")
+{
+    auto a = false;
+    auto b = false;
+    auto c = false;
+
+    auto cli = libcli::cli{};
+    cli.add_option(a, "--a", "-a");
+    cli.add_option(b, "--b", "-b");
+    cli.add_option(c, "--c", "-c");
+
+    SECTION("-bca")
+    {
+        cli.parse({"app_name", "-bca"});
+        REQUIRE(a == true);
+        REQUIRE(b == true);
+        REQUIRE(c == true);
+    }
+
+    SECTION("-abo")
+    {
+        auto o = 0;
+        cli.add_option(o, "--o", "-o");
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "-abo"}),
+            libcli::parsing_error);
+    }
+}
+
+TEST_CASE("token view")
+{
+    using view = libcli::detail::program_arguments_token_view;
+    static_assert(std::ranges::input_range<view>);
+    static_assert(std::is_same_v<
+                  std::ranges::range_reference_t<view>,
+                  libcli::detail::token const&>);
+}
+
 TEST_CASE("std::optional<bool>")
 {
     auto cli = libcli::cli{};
@@ -221,6 +443,1150 @@ TEST_CASE("std::optional<bool>")
     REQUIRE(opt2.value() == false);
 }
 
+TEST_CASE("parse borrowed string views")
+{
+    auto storage = std::vector<std::string>{
+        "app_name",
+        "--label=coords",
+        "-n",
+        "7",
+        "positional"};
+    auto const views =
+        std::vector<std::string_view>(storage.begin(), storage.end());
+
+    auto label = std::string{};
+    auto number = 0;
+    auto arg = std::string{};
+
+    auto cli = libcli::cli{};
+    cli.add_option(label, "--label", "-l");
+    cli.add_option(number, "--number", "-n");
+    cli.add_argument(arg);
+    cli.parse(views);
+
+    REQUIRE(label == "coords");
+    REQUIRE(number == 7);
+    REQUIRE(arg == "positional");
+    REQUIRE_THROWS_AS(
+        cli.parse(std::span<std::string_view const>{}),
+        std::logic_error);
+}
+
+TEST_CASE("option index matches linear lookup")
+{
+    auto flags = std::array<bool, 52>{};
+    auto table = libcli::detail::option_table{};
+    auto candidates = std::vector<std::string>{"-", "--", "-0", "-\x7f"};
+    for (auto i = std::size_t{0}; i < flags.size(); ++i) {
+        auto const letter = i < 26 ? static_cast<char>('z' - i)
+                                   : static_cast<char>('A' + i - 26);
+        auto name = "--option-"s + std::to_string(i * 7919 % 101);
+        auto shorthand = "-"s + letter;
+        candidates.push_back(name);
+        candidates.push_back(name + "x");
+        candidates.push_back(name.substr(0, name.size() - 1));
+        candidates.push_back(shorthand);
+        candidates.push_back("--"s + letter);
+        table.push_back(libcli::detail::option{
+            libcli::detail::bound_flag{flags[i]},
+            std::pmr::string{name},
+            std::pmr::string{shorthand},
+            {}});
+    }
+
+    for (std::string_view const candidate : candidates) {
+        auto const it = std::ranges::find_if(table, [&](auto const& o) {
+            return o.shorthand == candidate || o.name == candidate;
+        });
+        auto const expected =
+            it == table.end()
+                ? std::nullopt
+                : std::optional{
+                    static_cast<std::size_t>(it - table.begin())};
+        REQUIRE(table.find(candidate) == expected);
+    }
+}
+
+TEST_CASE("static cli")
+{
+    auto flag = false;
+    auto number = std::optional<int>{};
+    auto label = ""s;
+    auto first = ""s;
+    auto second = 0.0;
+
+    auto cli = libcli::static_cli<
+        libcli::static_option<"--flag", "-f", bool>,
+        libcli::static_argument<std::string>,
+        libcli::static_option<"--number", "-n", std::optional<int>>,
+        libcli::static_option<"--label", "-l", std::string>,
+        libcli::static_argument<double>>{flag, first, number, label, second};
+
+    SECTION("options and arguments")
+    {
+        cli.parse({"app_name", "-f", "-n3", "one", "--label=x", "--", "-2.5"});
+        REQUIRE(flag == true);
+        REQUIRE(number == 3);
+        REQUIRE(label == "x");
+        REQUIRE(first == "one");
+        REQUIRE(second == -2.5);
+    }
+
+    SECTION("errors")
+    {
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "--unknown", "one", "2"}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "--flag=1", "one", "2"}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "-n"}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "one"}),
+            libcli::parsing_error);
+    }
+
+    static_assert(libcli::detail::is_valid_option_name("--a-1"));
+    static_assert(!libcli::detail::is_valid_option_name("--"));
+    static_assert(!libcli::detail::is_valid_option_name("-ab"));
+    static_assert(!libcli::detail::is_valid_option_name("--a_b"));
+    static_assert(libcli::detail::is_valid_option_shorthand("-a"));
+    static_assert(!libcli::detail::is_valid_option_shorthand("-1"));
+    static_assert(!libcli::detail::is_valid_option_shorthand("--"));
+
+    constexpr auto table = libcli::detail::static_option_table<3>{{{
+        {"--b", "-b", true},
+        {"--a", "-a", false},
+        {"--b", "-c", false},
+    }}};
+    static_assert(table.find("--a") == 1);
+    static_assert(table.find("-c") == 2);
+    static_assert(!table.find("--c"));
+    static_assert(table.has_unique_shorthands());
+    static_assert(!table.has_unique_names());
+}
+
+TEST_CASE("bindings are stored inline")
+{
+    static_assert(sizeof(libcli::detail::bound_value) == 2 * sizeof(void*));
+    static_assert(
+        sizeof(libcli::detail::bound_container) == 2 * sizeof(void*));
+    static_assert(
+        std::is_trivially_copyable_v<libcli::detail::option::bound_variable>);
+}
+
+class counting_resource : public std::pmr::memory_resource {
+    std::pmr::memory_resource* upstream;
+
+   public:
+    std::size_t allocations = 0;
+
+    explicit counting_resource(
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream{upstream}
+    {
+    }
+
+   private:
+    auto do_allocate(std::size_t bytes, std::size_t alignment)
+        -> void* override
+    {
+        ++allocations;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+        override
+    {
+        upstream->deallocate(p, bytes, alignment);
+    }
+
+    auto do_is_equal(std::pmr::memory_resource const& other) const noexcept
+        -> bool override
+    {
+        return this == &other;
+    }
+};
+
+TEST_CASE("memory resources")
+{
+    auto definitions = counting_resource{};
+    auto flag = false;
+    auto name = ""s;
+    auto args = std::vector<std::string>{};
+
+    auto cli = libcli::cli{&definitions};
+    cli.add_option(flag, "--a-rather-long-flag-name", "-f");
+    cli.add_option(name, "--a-rather-long-option-name", "-n");
+    cli.add_argument(libcli::multi, args);
+    auto const definition_allocations = definitions.allocations;
+    REQUIRE(definition_allocations > 0);
+
+    auto buffer = std::array<std::byte, 1024>{};
+    auto arena = std::pmr::monotonic_buffer_resource{
+        buffer.data(),
+        buffer.size(),
+        std::pmr::null_memory_resource()};
+    auto per_parse = counting_resource{&arena};
+    auto const argv = std::array{
+        "app_name",
+        "-f",
+        "--a-rather-long-option-name=x",
+        "a",
+        "b"};
+    cli.parse(argv.size(), argv.data(), &per_parse);
+
+    REQUIRE(per_parse.allocations > 0);
+    REQUIRE(definitions.allocations == definition_allocations);
+    REQUIRE(flag == true);
+    REQUIRE(name == "x");
+    REQUIRE(args == std::vector{"a"s, "b"s});
+}
+
+class temporary_file {
+    std::filesystem::path path_;
+
+   public:
+    temporary_file(std::string const& name, std::string_view contents)
+        : path_{std::filesystem::temp_directory_path() / name}
+    {
+        auto file = std::ofstream{path_, std::ios::binary};
+        file.write(
+            contents.data(),
+            static_cast<std::streamsize>(contents.size()));
+    }
+
+    temporary_file(temporary_file const&) = delete;
+    auto operator=(temporary_file const&) -> temporary_file& = delete;
+
+    ~temporary_file() { std::filesystem::remove(path_); }
+
+    auto path() const -> std::string { return path_.string(); }
+
+    auto arg() const -> std::string { return "@" + path(); }
+};
+
+TEST_CASE("response files")
+{
+    auto flag = false;
+    auto label = ""s;
+    auto args = std::vector<std::string>{};
+
+    auto cli = libcli::cli{};
+    cli.add_option(flag, "--flag", "-f");
+    cli.add_option(label, "--label", "-l");
+    cli.add_argument(libcli::multi, args);
+
+    SECTION("quoting")
+    {
+        auto const file = temporary_file{
+            "libcli_rsp_quoting",
+            "  --label \"two words\"\n'a \\b' c\\ d\te\"\\\"\"\n"};
+        auto const rsp = file.arg();
+        cli.enable_response_files();
+        cli.parse({"app_name", "-f", rsp.c_str(), "last"});
+        REQUIRE(flag == true);
+        REQUIRE(label == "two words");
+        REQUIRE(args == std::vector{"a \\b"s, "c d"s, "e\""s, "last"s});
+    }
+
+    SECTION("long arguments")
+    {
+        // Longer than the sixteen characters scanned at a time, with every
+        // kind of separator and escape past the first chunk.
+        auto const file = temporary_file{
+            "libcli_rsp_long",
+            "abcdefghijklmnopqrstuvwxyz\v0123456789abcdefghij\f"
+            "abcdefghijklmnopq\\ rstu\"vw xyz\"0123456789'ab\\'\r\n"
+            "0123456789012345"};
+        auto const rsp = file.arg();
+        cli.enable_response_files();
+        cli.parse({"app_name", rsp.c_str()});
+        REQUIRE(
+            args
+            == std::vector{
+                "abcdefghijklmnopqrstuvwxyz"s,
+                "0123456789abcdefghij"s,
+                "abcdefghijklmnopq rstuvw xyz0123456789ab\\"s,
+                "0123456789012345"s});
+    }
+
+    SECTION("nul separated and nested")
+    {
+        auto const inner = temporary_file{"libcli_rsp_inner", "x y\0z"s};
+        auto const outer = temporary_file{
+            "libcli_rsp_outer",
+            "--label=\0"s + inner.arg() + "\0--\0"s + inner.arg()};
+        auto const rsp = outer.arg();
+        cli.enable_response_files(libcli::response_file_format::nul_separated);
+        cli.parse({"app_name", rsp.c_str()});
+        REQUIRE(label.empty());
+        REQUIRE(args == std::vector{"x y"s, "z"s, inner.arg()});
+    }
+
+    SECTION("disabled")
+    {
+        cli.parse({"app_name", "@not-a-file"});
+        REQUIRE(args == std::vector{"@not-a-file"s});
+    }
+
+    SECTION("errors")
+    {
+        auto const self = temporary_file{"libcli_rsp_self", ""};
+        auto const cycle = temporary_file{"libcli_rsp_cycle", self.arg()};
+        {
+            auto file = std::ofstream{
+                std::filesystem::temp_directory_path() / "libcli_rsp_self"};
+            file << cycle.arg();
+        }
+        auto const quote = temporary_file{"libcli_rsp_quote", "'a"};
+        auto const cycle_arg = cycle.arg();
+        auto const quote_arg = quote.arg();
+
+        cli.enable_response_files();
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", cycle_arg.c_str()}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", quote_arg.c_str()}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "@/nonexistent/libcli"}),
+            libcli::parsing_error);
+    }
+}
+
+struct job_options {
+    bool verbose = false;
+    std::optional<int> priority;
+    std::string name;
+    std::string command;
+    std::vector<std::string> args;
+};
+
+TEST_CASE("parser")
+{
+    auto p = libcli::parser<job_options>{};
+    p.add_option<&job_options::verbose>("--verbose", "-v");
+    p.add_option<&job_options::priority>("--priority", "-p");
+    p.add_option<&job_options::name>("--name", "-n");
+    p.add_argument<&job_options::command>();
+    p.add_argument<&job_options::args>(libcli::multi);
+
+    SECTION("parse")
+    {
+        auto const opts = p.parse({"app_name", "-v", "-p3", "run", "a", "b"});
+        REQUIRE(opts.verbose == true);
+        REQUIRE(opts.priority == 3);
+        REQUIRE(opts.name.empty());
+        REQUIRE(opts.command == "run");
+        REQUIRE(opts.args == std::vector{"a"s, "b"s});
+
+        auto const other = p.parse({"app_name", "--name=x", "stop", "c"});
+        REQUIRE(other.verbose == false);
+        REQUIRE(!other.priority);
+        REQUIRE(other.name == "x");
+        REQUIRE(other.args == std::vector{"c"s});
+    }
+
+    SECTION("definition errors")
+    {
+        REQUIRE_THROWS_AS(
+            p.add_option<&job_options::name>("--verbose", "-x"),
+            libcli::invalid_cli_definition);
+        REQUIRE_THROWS_AS(
+            p.add_argument<&job_options::args>(libcli::multi),
+            libcli::invalid_cli_definition);
+    }
+
+    SECTION("concurrent parses")
+    {
+        auto const& shared = p;
+        auto mismatches = std::array<int, 4>{};
+        auto threads = std::vector<std::thread>{};
+        for (auto t = std::size_t{0}; t < mismatches.size(); ++t) {
+            threads.emplace_back([&shared, &mismatches, t] {
+                auto const priority = std::to_string(t);
+                for (auto i = 0; i < 1000; ++i) {
+                    auto const opts = shared.parse(
+                        {"app_name", "-p", priority.c_str(), "cmd", "x"});
+                    if (opts.priority != static_cast<int>(t)) {
+                        ++mismatches[t];
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) { thread.join(); }
+        REQUIRE(mismatches == std::array<int, 4>{});
+    }
+
+    SECTION("batch")
+    {
+        auto lines = std::vector<std::vector<std::string>>{};
+        for (auto i = 0; i < 1000; ++i) {
+            if (i % 7 == 0) { lines.push_back({"app_name", "--bad"}); }
+            else {
+                lines.push_back(
+                    {"app_name", "-p", std::to_string(i), "cmd", "x"});
+            }
+        }
+        auto const results = p.parse_batch(lines, 4);
+        REQUIRE(results.size() == lines.size());
+        for (auto i = 0; i < 1000; ++i) {
+            auto const& r = results[static_cast<std::size_t>(i)];
+            if (i % 7 == 0) {
+                REQUIRE(std::holds_alternative<libcli::parsing_error>(r));
+            }
+            else {
+                REQUIRE(std::get<job_options>(r).priority == i);
+            }
+        }
+
+        auto const views = std::vector<std::vector<std::string_view>>{
+            {"app_name", "cmd", "a"},
+            {"app_name"},
+            {}};
+        auto const view_results = p.parse_batch(views);
+        REQUIRE(std::get<job_options>(view_results[0]).args.size() == 1);
+        REQUIRE(
+            std::holds_alternative<libcli::parsing_error>(view_results[1]));
+        REQUIRE(
+            std::string{std::get<libcli::parsing_error>(view_results[2]).what()}
+            == "Input cannot be empty");
+        auto const empty_results =
+            p.parse_batch(std::vector<std::vector<char const*>>(3));
+        REQUIRE(
+            std::holds_alternative<libcli::parsing_error>(empty_results[2]));
+        REQUIRE(p.parse_batch(std::vector<std::vector<char const*>>{}).empty());
+    }
+}
+
+TEST_CASE("subcommands")
+{
+    auto verbose = false;
+    auto defined = std::vector<std::string>{};
+    auto force = false;
+    auto files = std::vector<std::string>{};
+    auto remote = std::string{};
+
+    auto cli = libcli::cli{};
+    cli.add_option(verbose, "--verbose", "-v");
+    cli.add_subcommand("add", [&](libcli::cli& sub) {
+        defined.emplace_back("add");
+        sub.add_option(force, "--force", "-f");
+        sub.add_argument(libcli::multi, files);
+    });
+    cli.add_subcommand("push", [&](libcli::cli& sub) {
+        defined.emplace_back("push");
+        sub.add_argument(remote);
+    });
+
+    SECTION("dispatch")
+    {
+        cli.parse({"app_name", "-v", "add", "-f", "a", "b"});
+        REQUIRE(verbose == true);
+        REQUIRE(force == true);
+        REQUIRE(files == std::vector{"a"s, "b"s});
+        REQUIRE(defined == std::vector{"add"s});
+
+        cli.parse({"app_name", "push", "origin"});
+        REQUIRE(remote == "origin");
+        REQUIRE(defined == std::vector{"add"s, "push"s});
+
+        // A -- before the command still ends the options of the command.
+        force = false;
+        files.clear();
+        cli.parse({"app_name", "--", "add", "-f", "a"});
+        REQUIRE(force == false);
+        REQUIRE(files == std::vector{"-f"s, "a"s});
+    }
+
+    SECTION("errors")
+    {
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "pull"}),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(cli.parse({"app_name", "-v"}), libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.parse({"app_name", "add", "-v", "a"}),
+            libcli::parsing_error);
+        REQUIRE(defined == std::vector{"add"s});
+
+        REQUIRE_THROWS_AS(
+            cli.add_subcommand("add", [](libcli::cli&) {}),
+            libcli::invalid_cli_definition);
+        REQUIRE_THROWS_AS(
+            cli.add_subcommand("-x", [](libcli::cli&) {}),
+            libcli::invalid_cli_definition);
+        REQUIRE_THROWS_AS(
+            cli.add_argument(remote),
+            libcli::invalid_cli_definition);
+    }
+}
+
+class environment_variable {
+    std::string name_;
+
+   public:
+    environment_variable(std::string name, std::string const& value)
+        : name_{std::move(name)}
+    {
+#if defined(_WIN32)
+        _putenv_s(name_.c_str(), value.c_str());
+#else
+        setenv(name_.c_str(), value.c_str(), 1);
+#endif
+    }
+
+    environment_variable(environment_variable const&) = delete;
+    auto operator=(environment_variable const&)
+        -> environment_variable& = delete;
+
+    ~environment_variable()
+    {
+#if defined(_WIN32)
+        _putenv_s(name_.c_str(), "");
+#else
+        unsetenv(name_.c_str());
+#endif
+    }
+};
+
+TEST_CASE("environment variables")
+{
+    auto const port_var = environment_variable{"LIBCLI_TEST_PORT", "8080"};
+    auto const level_var =
+        environment_variable{"LIBCLI_TEST_LOG_LEVEL", "debug"};
+    auto const flag_var = environment_variable{"LIBCLI_TEST_DRY_RUN", "1"};
+
+    auto port = 0;
+    auto level = ""s;
+    auto dry_run = false;
+    auto cli = libcli::cli{};
+    cli.add_option(port, "--port", "-p", "LIBCLI_TEST_PORT");
+    cli.add_option(level, "--log-level", "-l");
+    cli.set_environment_prefix("LIBCLI_TEST_");
+    cli.add_option(dry_run, "--dry-run", "-d");
+
+    SECTION("fallback")
+    {
+        cli.parse({"app_name"});
+        REQUIRE(port == 8080);
+        REQUIRE(level == "debug");
+        REQUIRE(dry_run == true);
+    }
+
+    SECTION("argv takes precedence")
+    {
+        cli.parse({"app_name", "-p", "9090", "--log-level=info"});
+        REQUIRE(port == 9090);
+        REQUIRE(level == "info");
+    }
+
+    SECTION("errors")
+    {
+        auto const bad_port = environment_variable{"LIBCLI_TEST_PORT", "x"};
+        REQUIRE_THROWS_AS(cli.parse({"app_name"}), libcli::parsing_error);
+
+        auto other = 0;
+        REQUIRE_THROWS_AS(
+            cli.add_option(other, "--other", "-o", "LIBCLI_TEST_PORT"),
+            libcli::invalid_cli_definition);
+        REQUIRE_THROWS_AS(
+            cli.add_option(other, "--port2", "-q", "A=B"),
+            libcli::invalid_cli_definition);
+        REQUIRE_THROWS_AS(
+            cli.set_environment_prefix("X_"),
+            libcli::invalid_cli_definition);
+    }
+
+    SECTION("rejected prefix")
+    {
+        auto other = 0;
+        auto prefixed = libcli::cli{};
+        prefixed.add_option(other, "--other", "-o", "APP_LOG_LEVEL");
+        prefixed.add_option(level, "--log-level", "-l");
+        REQUIRE_THROWS_AS(
+            prefixed.set_environment_prefix("APP_"),
+            libcli::invalid_cli_definition);
+        REQUIRE_NOTHROW(prefixed.set_environment_prefix("LIBCLI_TEST_"));
+        prefixed.parse({"app_name"});
+        REQUIRE(level == "debug");
+    }
+}
+
+TEST_CASE("config files")
+{
+    auto port = 0;
+    auto host = ""s;
+    auto verbose = false;
+    auto level = ""s;
+    auto cli = libcli::cli{};
+    cli.add_option(port, "--server-port", "-p", "LIBCLI_TEST_SERVER_PORT");
+    cli.add_option(host, "--server-host", "-H");
+    cli.add_option(verbose, "--verbose", "-v");
+    cli.add_option(level, "--log-level", "-l");
+
+    SECTION("layers")
+    {
+        auto const file = temporary_file{
+            "libcli_config_layers",
+            "# comment\n"
+            "verbose = true\n"
+            "log-level=\"warn ing\"\r\n"
+            "\n"
+            "[server]\n"
+            "  port = 80\n"
+            "host = example.org\n"};
+        cli.load_config(file.path());
+        REQUIRE(verbose == true);
+        REQUIRE(level == "warn ing");
+        REQUIRE(port == 80);
+        REQUIRE(host == "example.org");
+
+        auto const env = environment_variable{"LIBCLI_TEST_SERVER_PORT", "81"};
+        cli.parse({"app_name", "-H", "localhost"});
+        REQUIRE(port == 81);
+        REQUIRE(host == "localhost");
+    }
+
+    SECTION("errors")
+    {
+        auto const unknown =
+            temporary_file{"libcli_config_unknown", "verbose = 1\nport = 1\n"};
+        auto const value =
+            temporary_file{"libcli_config_value", "[server]\nport = x\n"};
+        auto const line = temporary_file{"libcli_config_line", "verbose\n"};
+        REQUIRE_THROWS_AS(
+            cli.load_config(unknown.path()),
+            libcli::parsing_error);
+        REQUIRE_THROWS_AS(cli.load_config(value.path()), libcli::parsing_error);
+        REQUIRE_THROWS_AS(cli.load_config(line.path()), libcli::parsing_error);
+        REQUIRE_THROWS_AS(
+            cli.load_config("/nonexistent/libcli.conf"),
+            libcli::parsing_error);
+    }
+}
+
+TEST_CASE("completion")
+{
+    auto verbose = false;
+    auto level = ""s;
+    auto force = false;
+    auto cli = libcli::cli{};
+    cli.add_option(verbose, "--verbose", "-v");
+    cli.add_option(level, "--level", "-l");
+    cli.add_subcommand("add", [&](libcli::cli& sub) {
+        sub.add_option(force, "--force", "-f");
+    });
+    cli.add_subcommand("apply", [](libcli::cli&) {});
+    cli.add_subcommand("branch", [](libcli::cli&) {});
+
+    auto const complete = [&](std::initializer_list<char const*> words) {
+        auto argv = std::vector<char const*>{"app_name", "__complete"};
+        argv.insert(argv.end(), words);
+        auto out = std::ostringstream{};
+        CHECK(cli.try_complete(
+            static_cast<int>(argv.size()),
+            argv.data(),
+            out));
+        return out.str();
+    };
+
+    REQUIRE(complete({"--"}) == "--level\n--verbose\n");
+    REQUIRE(complete({"--v"}) == "--verbose\n");
+    REQUIRE(complete({"a"}) == "add\napply\n");
+    REQUIRE(complete({}) == "add\napply\nbranch\n");
+    REQUIRE(complete({"-v", "add", "--f"}) == "--force\n");
+    REQUIRE(complete({"--level", ""}).empty());
+    REQUIRE(complete({"--level", "x", "b"}) == "branch\n");
+
+    auto out = std::ostringstream{};
+    auto const argv = std::array{"app_name", "add"};
+    REQUIRE(!cli.try_complete(2, argv.data(), out));
+    REQUIRE(out.str().empty());
+
+    auto const script =
+        cli.completion_script(libcli::completion_shell::bash, "app-name");
+    REQUIRE(script.find("app-name __complete") != std::string::npos);
+    REQUIRE(script.find("-F _app_name_complete app-name") != std::string::npos);
+}
+
+TEST_CASE("try_parse")
+{
+    using libcli::parse_errc;
+    constexpr auto npos = libcli::parse_error::npos;
+
+    auto flag = false;
+    auto number = 0;
+    auto name = ""s;
+    auto cli = libcli::cli{};
+    cli.add_option(flag, "--flag", "-f");
+    cli.add_option(number, "--number", "-n");
+    cli.add_argument(name);
+
+    SECTION("success")
+    {
+        auto const result = cli.try_parse({"app_name", "-f", "-n3", "x"});
+        REQUIRE(result.has_value());
+        REQUIRE(flag == true);
+        REQUIRE(number == 3);
+        REQUIRE(name == "x");
+    }
+
+    SECTION("errors")
+    {
+        struct expectation {
+            std::vector<char const*> argv;
+            parse_errc kind;
+            std::size_t argv_index;
+            std::size_t option_index;
+            std::string message;
+        };
+        auto const expectations = std::vector<expectation>{
+            {{"app_name", "--nope"},
+             parse_errc::not_an_option, 1, npos,
+             "--nope is not an option"},
+            {{"app_name", "x", "-fz"},
+             parse_errc::not_an_option, 2, npos,
+             "-z is not an option"},
+            {{"app_name", "-"},
+             parse_errc::not_an_option, 1, npos,
+             "- is not an option"},
+            {{"app_name", "-fn", "x"},
+             parse_errc::not_a_flag, 1, 1,
+             "-n is not a flag"},
+            {{"app_name", "--flag=1"},
+             parse_errc::flag_with_value, 1, 0,
+             "--flag=1 is invalid"},
+            {{"app_name", "x", "-n"},
+             parse_errc::missing_value, 2, 1,
+             "-n is missing an argument"},
+            {{"app_name", "-n", "abc", "x"},
+             parse_errc::invalid_value, 2, 1,
+             "abc is not a valid value"},
+            {{"app_name", "--number=99999999999", "x"},
+             parse_errc::out_of_range, 1, 1,
+             "99999999999 is out of range"},
+            {{"app_name", "-f"},
+             parse_errc::wrong_number_of_arguments, npos, npos,
+             "Wrong number of arguments"},
+        };
+        for (auto const& e : expectations) {
+            auto const result = cli.try_parse(
+                static_cast<int>(e.argv.size()),
+                e.argv.data());
+            REQUIRE(!result);
+            REQUIRE(result.error().kind == e.kind);
+            REQUIRE(result.error().argv_index == e.argv_index);
+            REQUIRE(result.error().option_index == e.option_index);
+            REQUIRE(result.error().message() == e.message);
+            REQUIRE_THROWS_AS(
+                cli.parse(static_cast<int>(e.argv.size()), e.argv.data()),
+                libcli::parsing_error);
+        }
+    }
+
+    SECTION("response files and subcommands")
+    {
+        auto const file = temporary_file{"libcli_try_parse", "-f --nope"};
+        auto const rsp = file.arg();
+        cli.enable_response_files();
+        auto const from_file = cli.try_parse({"app_name", "x", rsp.c_str()});
+        REQUIRE(!from_file);
+        REQUIRE(from_file.error().argv_index == 2);
+        REQUIRE(from_file.error().text == "--nope");
+        REQUIRE(from_file.error().message() == "--nope is not an option");
+        auto message = ""s;
+        try {
+            cli.parse({"app_name", "x", rsp.c_str()});
+        }
+        catch (libcli::parsing_error const& ex) {
+            message = ex.what();
+        }
+        REQUIRE(message == "--nope is not an option");
+        auto const values = temporary_file{"libcli_try_parse_value", "-n abc"};
+        auto const values_rsp = values.arg();
+        auto const bad_value =
+            cli.try_parse({"app_name", values_rsp.c_str(), "x"});
+        REQUIRE(!bad_value);
+        REQUIRE(bad_value.error().argv_index == 1);
+        REQUIRE(bad_value.error().message() == "abc is not a valid value");
+
+        auto force = false;
+        auto git = libcli::cli{};
+        git.add_option(flag, "--flag", "-f");
+        git.add_subcommand("add", [&](libcli::cli& sub) {
+            sub.add_option(force, "--force", "-F");
+        });
+        auto const in_command =
+            git.try_parse({"app_name", "-f", "add", "-F", "--nope"});
+        REQUIRE(!in_command);
+        REQUIRE(in_command.error().argv_index == 4);
+        REQUIRE(git.try_parse({"app_name", "-f"}).error().kind
+                == parse_errc::missing_command);
+    }
+
+    SECTION("parser")
+    {
+        auto p = libcli::parser<job_options>{};
+        p.add_option<&job_options::priority>("--priority", "-p");
+        p.add_argument<&job_options::command>();
+
+        auto const ok = p.try_parse({"app_name", "-p", "2", "run"});
+        REQUIRE(ok);
+        REQUIRE(ok->priority == 2);
+        REQUIRE(ok->command == "run");
+
+        auto const bad = p.try_parse({"app_name", "run", "-p", "high"});
+        REQUIRE(!bad);
+        REQUIRE(bad.error().kind == parse_errc::invalid_value);
+        REQUIRE(bad.error().argv_index == 3);
+        REQUIRE(bad.error().option_index == 0);
+    }
+}
+
+TEST_CASE("help")
+{
+    auto verbose = false;
+    auto port = 0;
+    auto files = std::vector<std::string>{};
+    auto cli = libcli::cli{};
+    cli.add_option(verbose, "--verbose", "-v")
+        .describe("Print more details about what is going on");
+    cli.add_option(port, "--port", "-p").describe("Port to listen on", "PORT");
+    cli.add_argument(libcli::multi, files).describe("Files to read", "FILE");
+
+    auto const text = cli.help("app", 40);
+    REQUIRE(
+        text
+        == "Usage: app [options] FILE...\n"
+           "\n"
+           "Arguments:\n"
+           "  FILE             Files to read\n"
+           "\n"
+           "Options:\n"
+           "  -v, --verbose    Print more details\n"
+           "                   about what is going\n"
+           "                   on\n"
+           "  -p, --port PORT  Port to listen on\n");
+    REQUIRE(cli.help("app", 40).data() == text.data());
+
+    auto name = ""s;
+    auto tools = libcli::cli{};
+    tools.add_option(name, "--name", "-n");
+    tools.add_subcommand("run", [](libcli::cli&) {}).describe("Run it");
+    REQUIRE(
+        tools.help("tools", 80)
+        == "Usage: tools [options] <command> [<args>]\n"
+           "\n"
+           "Options:\n"
+           "  -n, --name VALUE\n"
+           "\n"
+           "Commands:\n"
+           "  run               Run it\n");
+}
+
+TEST_CASE("bulk option registration")
+{
+    auto verbose = false;
+    auto port = 0;
+    auto name = std::optional<std::string>{};
+    auto cli = libcli::cli{};
+    cli.add_option(verbose, "--verbose", "-v");
+    cli.add_options({
+        {port, "--port", "-p"},
+        libcli::option_definition{name, "--name"}.describe("Who", "NAME"),
+    });
+    cli.parse({"app", "-v", "-p", "80", "--name", "x"});
+    REQUIRE(verbose);
+    REQUIRE(port == 80);
+    REQUIRE(name == "x");
+    REQUIRE(cli.help("app", 80).ends_with("      --name NAME   Who\n"));
+
+    auto other = 0;
+    auto message = ""s;
+    try {
+        cli.add_options({
+            {other, "--other", "-o"},
+            {other, "--port"},
+            {other, "--again", "-o"},
+            {other, "--third", "-o"},
+            {other, "--other"},
+        });
+    }
+    catch (libcli::invalid_cli_definition const& ex) {
+        message = ex.what();
+    }
+    REQUIRE(message == "Options are already defined: --other --port -o");
+
+    cli.add_option(other, "--other", "-o", "OTHER");
+    try {
+        cli.add_options({
+            {port, "--a", {}, "SAME"},
+            {port, "--b", {}, "SAME"},
+            {port, "--c", {}, "SAME"},
+            {port, "--d", {}, "OTHER"},
+        });
+    }
+    catch (libcli::invalid_cli_definition const& ex) {
+        message = ex.what();
+    }
+    REQUIRE(
+        message
+        == "Environment variables are used by more than one option: OTHER "
+           "SAME");
+    REQUIRE_THROWS_AS(cli.parse({"app", "--a", "1"}), libcli::parsing_error);
+}
+
+struct name_recorder : libcli::parse_observer {
+    std::vector<std::string> names;
+    std::vector<libcli::parse_phase> phases;
+
+    void on_phase_begin(libcli::parse_phase phase) { phases.push_back(phase); }
+
+    void on_unknown_name(std::string_view name) { names.emplace_back(name); }
+};
+
+// Forwards every allocation to whatever upstream it was last handed.
+struct allocation_counter
+    : libcli::parse_observer
+    , std::pmr::memory_resource {
+    std::pmr::memory_resource* upstream = nullptr;
+    std::size_t num_wraps = 0;
+    std::size_t num_allocations = 0;
+
+    auto wrap_resource(std::pmr::memory_resource* resource)
+        -> std::pmr::memory_resource*
+    {
+        ++num_wraps;
+        upstream = resource;
+        return this;
+    }
+
+    auto do_allocate(std::size_t bytes, std::size_t alignment)
+        -> void* override
+    {
+        ++num_allocations;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment)
+        override
+    {
+        upstream->deallocate(ptr, bytes, alignment);
+    }
+
+    auto do_is_equal(std::pmr::memory_resource const& other) const noexcept
+        -> bool override
+    {
+        return this == &other;
+    }
+};
+
+TEST_CASE("parse observers")
+{
+    auto verbose = false;
+    auto port = 0;
+    auto files = std::vector<int>{};
+    auto cli = libcli::cli{};
+    cli.add_option(verbose, "--verbose", "-v");
+    cli.add_option(port, "--port", "-p");
+    cli.add_argument(libcli::parallel_multi, files);
+
+    auto stats = libcli::parse_statistics{};
+    cli.parse({"app", "-v", "1", "--port=80", "2", "3"}, stats);
+    REQUIRE(stats.num_tokens(libcli::token_kind::flag) == 1);
+    REQUIRE(stats.num_tokens(libcli::token_kind::option) == 1);
+    REQUIRE(stats.num_tokens(libcli::token_kind::positional) == 3);
+    REQUIRE(stats.option_conversions == std::vector<std::size_t>{0, 1});
+    REQUIRE(stats.argument_conversions == std::vector<std::size_t>{3});
+    REQUIRE(stats.failed_conversions == 0);
+    REQUIRE(stats.failed_lookups == 0);
+    REQUIRE(stats.duration(libcli::parse_phase::arguments).count() > 0);
+    REQUIRE(stats.num_allocations() > 0);
+    REQUIRE(stats.allocated_bytes() >= 6 * sizeof(std::string_view));
+
+    REQUIRE_FALSE(cli.try_parse({"app", "-p", "x"}, stats));
+    REQUIRE(stats.failed_conversions == 1);
+
+    auto recorder = name_recorder{};
+    REQUIRE_THROWS_AS(
+        cli.parse({"app", "1", "--colour"}, recorder),
+        libcli::parsing_error);
+    REQUIRE(recorder.names == std::vector{"--colour"s});
+    REQUIRE(
+        recorder.phases == std::vector{libcli::parse_phase::arguments});
+
+    // The resource is wrapped once, however many entry points and
+    // subcommands the parse goes through.
+    auto counter = allocation_counter{};
+    auto git = libcli::cli{};
+    git.add_subcommand("add", [&](libcli::cli& sub) {
+        sub.add_argument(libcli::multi, files);
+    });
+    git.parse({"app", "add", "1", "2"}, counter);
+    REQUIRE(counter.num_wraps == 1);
+    REQUIRE(counter.num_allocations > 0);
+    REQUIRE(git.try_parse({"app", "add", "3"}, counter));
+    REQUIRE(counter.num_wraps == 2);
+}
+
+struct counted_conversion {
+    static inline auto count = 0;
+    int value = 0;
+
+    friend auto operator>>(std::istream& is, counted_conversion& x)
+        -> std::istream&
+    {
+        ++count;
+        return is >> x.value;
+    }
+};
+
+TEST_CASE("lazy values")
+{
+    auto size = libcli::lazy<counted_conversion>{};
+    auto port = libcli::lazy<int>{8080};
+    auto files = std::vector<libcli::lazy<int>>{};
+    auto cli = libcli::cli{};
+    cli.add_option(size, "--size", "-s");
+    cli.add_option(port, "--port", "-p");
+    cli.add_argument(libcli::multi, files);
+
+    counted_conversion::count = 0;
+    cli.parse({"app", "--size", "12", "1", "x"});
+    REQUIRE(counted_conversion::count == 0);
+    REQUIRE(size.has_text());
+    REQUIRE(size.raw() == "12");
+    REQUIRE(size->value == 12);
+    REQUIRE(size->value == 12);
+    REQUIRE(counted_conversion::count == 1);
+    REQUIRE_FALSE(port.has_text());
+    REQUIRE(*port == 8080);
+    REQUIRE(files.size() == 2);
+    REQUIRE(*files[0] == 1);
+    REQUIRE_THROWS_AS(*files[1], libcli::parsing_error);
+
+    auto message = ""s;
+    try {
+        cli.validate_all();
+    }
+    catch (libcli::parsing_error const& ex) {
+        message = ex.what();
+    }
+    REQUIRE(message == "x is not a valid value");
+
+    files.clear();
+    cli.parse({"app", "-p", "99", "2"});
+    REQUIRE(*port == 99);
+    REQUIRE_NOTHROW(cli.validate_all());
+
+    // Lazy values of a command are checked by the cli that ran it.
+    auto depth = libcli::lazy<int>{};
+    auto git = libcli::cli{};
+    git.add_subcommand("clone", [&](libcli::cli& sub) {
+        sub.add_option(depth, "--depth", "-d");
+    });
+    git.parse({"app", "clone", "--depth", "deep"});
+    REQUIRE_THROWS_AS(git.validate_all(), libcli::parsing_error);
+    git.parse({"app", "clone", "--depth", "1"});
+    REQUIRE_NOTHROW(git.validate_all());
+}
+
+enum class feature : std::uint8_t { fast = 1, safe = 2, loud = 4 };
+
+template <typename T>
+concept has_bits = requires(T& var) { libcli::bit(var, 0); };
+
+static_assert(has_bits<std::uint8_t>);
+static_assert(!has_bits<bool>);
+
+TEST_CASE("flags bound to bits")
+{
+    auto word = std::uint32_t{0};
+    auto features = feature{};
+    auto toggles = std::bitset<100>{};
+    auto cli = libcli::cli{};
+    cli.add_option(libcli::bit(word, 0), "--first", "-a");
+    cli.add_option(libcli::bit(word, 31), "--last", "-b");
+    cli.add_option(libcli::bit(features, feature::fast), "--fast", "-f");
+    cli.add_option(libcli::bit(features, feature::loud), "--loud", "-l");
+    cli.add_options({
+        {libcli::bit(toggles, 99), "--toggle", "-t", "LIBCLI_TEST_TOGGLE"},
+    });
+
+    auto const toggle = environment_variable{"LIBCLI_TEST_TOGGLE", "0"};
+    toggles.set();
+    cli.parse({"app", "-abl", "--fast"});
+    REQUIRE(word == 0x8000'0001U);
+    REQUIRE(features == feature{5});
+    REQUIRE_FALSE(toggles[99]);
+    REQUIRE(toggles.count() == 99);
+
+    // Letters of one word are written at once, after all are looked up.
+    word = 0;
+    auto stats = libcli::parse_statistics{};
+    cli.parse({"app", "-ba"}, stats);
+    REQUIRE(word == 0x8000'0001U);
+    REQUIRE(stats.num_tokens(libcli::token_kind::flag) == 2);
+    auto const error = cli.try_parse({"app", "-abz"});
+    REQUIRE(!error);
+    REQUIRE(error.error().message() == "-z is not an option");
+    word = 0;
+    toggles.reset();
+    cli.parse({"app", "-at"});
+    REQUIRE(word == 1);
+    REQUIRE(toggles[99]);
+
+    REQUIRE_THROWS_AS(libcli::bit(word, 32), libcli::invalid_cli_definition);
+    REQUIRE_THROWS_AS(
+        libcli::bit(toggles, 100),
+        libcli::invalid_cli_definition);
+    REQUIRE_THROWS_AS(
+        libcli::bit(features, feature{}),
+        libcli::invalid_cli_definition);
+}
+
+TEST_CASE("string view bindings")
+{
+    auto name = std::string_view{};
+    auto paths = std::vector<std::string_view>{};
+    auto cli = libcli::cli{};
+    cli.add_option(name, "--name", "-n");
+    cli.add_argument(libcli::multi, paths);
+
+    auto const argv = std::array{"app", "-n", "x", "a", "b", "c"};
+    cli.parse(static_cast<int>(argv.size()), argv.data());
+    REQUIRE(name.data() == argv[2]);
+    REQUIRE(paths == std::vector{"a"sv, "b"sv, "c"sv});
+
+    // The files stay mapped after the parse, as the views point into them.
+    paths.clear();
+    auto const config = temporary_file{"libcli_views.conf", "name = y\n"};
+    cli.load_config(config.path());
+    auto const rsp = temporary_file{"libcli_views_rsp", "d e"};
+    auto const rsp_arg = rsp.arg();
+    cli.enable_response_files();
+    cli.parse({"app", rsp_arg.c_str()});
+    REQUIRE(name == "y");
+    REQUIRE(paths == std::vector{"d"sv, "e"sv});
+
+    // A subcommand's cli is gone after the parse, its files are not.
+    auto views = std::vector<std::string_view>{};
+    auto git = libcli::cli{};
+    git.add_subcommand("cmd", [&](libcli::cli& sub) {
+        sub.enable_response_files();
+        sub.add_argument(libcli::multi, views);
+    });
+    auto const args = temporary_file{"libcli_views_args.txt", "f g"};
+    auto const args_arg = args.arg();
+    git.parse({"app", "cmd", args_arg.c_str()});
+    REQUIRE(views == std::vector{"f"sv, "g"sv});
+}
+
 TEST_CASE("main test")
 {
     auto argv = std::array{